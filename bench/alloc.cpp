@@ -0,0 +1,57 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  // A typical request body: a small object with nested records
+  std::string request(size_t i) {
+    std::string text = "{\"request_id\": \"req-" + std::to_string(i) + "\"" +
+      ", \"user\": {\"id\": " + std::to_string(i * 7) +
+      ", \"name\": \"customer number " + std::to_string(i) + "\"" +
+      ", \"verified\": true,}" +
+      ", \"items\": [";
+
+    for(size_t j = 0; j < 8; ++j) {
+      if(j) text += ", ";
+      text += "{\"sku\": \"item-" + std::to_string(j) + "\", \"quantity\": " +
+        std::to_string(j + 1) + ", \"price\": " + std::to_string(j) + ".99}";
+    }
+
+    return text + "]}";
+  }
+
+  template<typename Parse>
+  void measure(const char* name, const std::string& text, size_t iterations,
+               Parse parse) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    for(size_t i = 0; i < iterations; ++i) {
+      parse(text);
+    }
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << name << ": "
+              << (double)(after.count - before.count) / iterations
+              << " allocations/parse, "
+              << seconds * 1e6 / iterations << " us/parse\n";
+  }
+}
+
+BENCHMARK(allocations_per_parse) {
+  const std::string text = request(42);
+  const size_t iterations = 100000;
+
+  measure("json::parse", text, iterations, [](const std::string& text) {
+    json::value value = json::parse(text);
+  });
+
+  json::document document;
+  measure("json::document", text, iterations, [&](const std::string& text) {
+    document.parse(text);
+  });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+
+namespace bench {
+  struct allocations {
+    size_t count = 0;
+    size_t bytes = 0;
+    size_t live = 0;
+    // Highest live byte count since the last reset_peak()
+    size_t peak = 0;
+  };
+
+  // Counters maintained by the global operator new/delete replacement
+  allocations allocated();
+  void reset_peak();
+
+  // Resident set size high-water mark, in bytes. On Linux it can be reset
+  // between measurements; elsewhere it covers the whole run.
+  size_t peak_rss();
+  void reset_rss();
+
+  struct metric {
+    const char* name;
+    double value;
+    const char* unit;
+  };
+
+  // Prints a measurement, and keeps it for the --json report
+  void record(const std::string& name, std::initializer_list<metric> metrics);
+
+  class registrar {
+    public:
+      registrar(const char* name, void (*run)());
+  };
+
+  class timer {
+    std::chrono::steady_clock::time_point start;
+    public:
+      timer() : start(std::chrono::steady_clock::now()) {}
+
+      double seconds() const {
+        std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+      }
+  };
+}
+
+#define BENCHMARK(name) \
+  static void bench_##name(); \
+  static bench::registrar registrar_##name(#name, bench_##name); \
+  static void bench_##name()
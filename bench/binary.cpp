@@ -0,0 +1,60 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <string>
+
+namespace {
+  // Runs `operation` for about a second and returns the seconds per run
+  template<typename Operation>
+  double time(Operation operation) {
+    size_t iterations = 0;
+    bench::timer timer;
+
+    do {
+      operation();
+      iterations++;
+    } while(iterations < 3 || (timer.seconds() < 1 && iterations < 100));
+
+    return timer.seconds() / iterations;
+  }
+
+  template<typename Encode, typename Decode>
+  void measure(const std::string& name, const json::value& document,
+               size_t text_size, Encode encode, Decode decode) {
+    const std::string encoded = encode(document);
+
+    const double encoding = time([&] { std::string output = encode(document); });
+    const double decoding = time([&] { json::value value = decode(encoded); });
+
+    // Throughput over the size of the text, so that formats compare directly
+    bench::record(name, {
+      { "size", (double)encoded.size() / text_size * 100, "% of text size" },
+      { "encode", text_size / encoding / (1024 * 1024), "MB/s encode" },
+      { "decode", text_size / decoding / (1024 * 1024), "MB/s decode" },
+    });
+  }
+}
+
+// to_cbor/from_cbor and to_msgpack/from_msgpack against to_string/parse
+BENCHMARK(binary_formats) {
+  for(const bench::corpus& corpus : bench::corpora()) {
+    if(corpus.lines) continue;
+
+    const std::string name = corpus.name;
+    const json::value document = json::parse(corpus.text);
+    const size_t size = document.to_string().size();
+
+    measure(name + "/text", document, size,
+      [](const json::value& value) { return value.to_string(); },
+      [](const std::string& text) { return json::parse(text); });
+
+    measure(name + "/cbor", document, size,
+      [](const json::value& value) { return json::to_cbor(value); },
+      [](const std::string& data) { return json::from_cbor(data); });
+
+    measure(name + "/msgpack", document, size,
+      [](const json::value& value) { return json::to_msgpack(value); },
+      [](const std::string& data) { return json::from_msgpack(data); });
+  }
+}
@@ -0,0 +1,60 @@
+#include "bench.h"
+
+#include <json.h>
+#include <string>
+#include <utility>
+
+namespace {
+  json::value row(int i) {
+    json::value row(json::value_type::object);
+    row.reserve(3);
+    row.insert_or_assign("id", i);
+    row.insert_or_assign("name", "a name long enough to be allocated " + std::to_string(i));
+    row.insert_or_assign("active", i % 2 == 0);
+    return row;
+  }
+
+  template<typename Build>
+  void measure(const std::string& name, Build build) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    json::value document = build();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    bench::record(name, {
+      { "rows", (double)document["rows"].size(), "rows" },
+      { "time", seconds * 1000, "ms" },
+      { "allocations", (double)(after.count - before.count), "allocations" },
+    });
+  }
+}
+
+// Building a large document by copying subtrees into place, and by moving them
+BENCHMARK(build_document) {
+  constexpr int count = 1000000;
+
+  measure("copy", [] {
+    json::value rows = json::array({});
+    for(int i = 0; i < count; ++i) {
+      const json::value element = row(i);
+      rows.emplace_back(json::value(element));
+    }
+
+    const json::value status = "ok";
+    json::value document(json::value_type::object);
+    document["status"] = status;
+    document["rows"] = rows;
+    return document;
+  });
+
+  measure("move", [] {
+    json::value rows = json::array({});
+    rows.reserve(count);
+    for(int i = 0; i < count; ++i) rows.emplace_back(row(i));
+
+    return json::value{ { "status", "ok" }, { "rows", std::move(rows) } };
+  });
+}
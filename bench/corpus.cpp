@@ -0,0 +1,238 @@
+#include "corpus.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+
+namespace {
+  // Fixed-seed generator (xorshift64*), identical on every platform
+  class generator {
+    std::uint64_t state = 0x9e3779b97f4a7c15;
+
+    public:
+      std::uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1d;
+      }
+
+      // In [0, bound)
+      size_t below(size_t bound) { return next() % bound; }
+
+      double unit() { return (next() >> 11) * 0x1.0p-53; }
+
+      const char* pick(std::initializer_list<const char*> choices) {
+        return choices.begin()[below(choices.size())];
+      }
+  };
+
+  std::string text(generator& rng, size_t words) {
+    std::string result;
+
+    for(size_t i = 0; i < words; ++i) {
+      if(i) result += ' ';
+      result += rng.pick({ "the", "release", "json", "parser", "today", "great",
+                           "new", "coffee", "weekend", "launch", "team", "data",
+                           "\\u00e9t\\u00e9", "caf\\u00e9", "\\ud83d\\ude80", "#dev" });
+    }
+
+    return result;
+  }
+
+  std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+  }
+}
+
+namespace bench {
+  std::string twitter(size_t statuses) {
+    generator rng;
+    std::string json = "{\"statuses\": [";
+
+    for(size_t i = 0; i < statuses; ++i) {
+      const std::string id = std::to_string(505874924095815680 + rng.below(1000000000));
+      const std::string user = std::to_string(1186275104 + rng.below(100000000));
+
+      if(i) json += ",";
+      json += "\n  {\"metadata\": {\"result_type\": \"recent\", \"iso_language_code\": \"" +
+        std::string(rng.pick({ "ja", "en", "fr", "es" })) + "\"}"
+        ", \"created_at\": \"Sun Aug 31 00:29:15 +0000 2014\""
+        ", \"id\": " + id + ", \"id_str\": \"" + id + "\""
+        ", \"text\": \"" + text(rng, 6 + rng.below(14)) + "\""
+        ", \"source\": \"<a href=\\\"https:\\/\\/mobile.twitter.com\\\" rel=\\\"nofollow\\\">Mobile Web<\\/a>\""
+        ", \"truncated\": false, \"in_reply_to_status_id\": null"
+        ", \"user\": {\"id\": " + user + ", \"id_str\": \"" + user + "\""
+        ", \"name\": \"" + text(rng, 2) + "\", \"screen_name\": \"user_" + std::to_string(rng.below(100000)) + "\""
+        ", \"location\": \"\", \"description\": \"" + text(rng, 4 + rng.below(10)) + "\""
+        ", \"url\": null, \"entities\": {\"description\": {\"urls\": []}}"
+        ", \"protected\": false, \"followers_count\": " + std::to_string(rng.below(100000)) +
+        ", \"friends_count\": " + std::to_string(rng.below(5000)) +
+        ", \"verified\": " + (rng.below(10) ? "false" : "true") +
+        ", \"profile_background_color\": \"C0DEED\", \"default_profile\": true}"
+        ", \"geo\": null, \"coordinates\": null, \"place\": null"
+        ", \"retweet_count\": " + std::to_string(rng.below(300)) +
+        ", \"favorite_count\": " + std::to_string(rng.below(300)) +
+        ", \"entities\": {\"hashtags\": [{\"text\": \"dev\", \"indices\": [" +
+        std::to_string(rng.below(40)) + ", " + std::to_string(40 + rng.below(40)) + "]}]"
+        ", \"symbols\": [], \"urls\": [], \"user_mentions\": []}"
+        ", \"favorited\": false, \"retweeted\": false, \"lang\": \"ja\"}";
+    }
+
+    return json + "\n], \"search_metadata\": {\"completed_in\": 0.087, \"count\": " +
+      std::to_string(statuses) + "}}";
+  }
+
+  std::string canada(size_t points) {
+    generator rng;
+    std::string json = "{\"type\": \"FeatureCollection\", \"features\": [{\"type\": \"Feature\""
+      ", \"properties\": {\"name\": \"Canada\"}, \"geometry\": {\"type\": \"Polygon\", \"coordinates\": [";
+
+    // Rings of a few hundred points each
+    for(size_t i = 0; i < points;) {
+      if(i) json += "],";
+      json += "\n[";
+
+      for(size_t ring = 0; ring < 400 && i < points; ++ring, ++i) {
+        if(ring) json += ",";
+        json += "[" + number(-141.0 + rng.unit() * 88.0) + "," +
+          number(41.7 + rng.unit() * 41.4) + "]";
+      }
+    }
+
+    return json + "]]}}]}";
+  }
+
+  std::string citm(size_t events) {
+    generator rng;
+    std::string json = "{\"areaNames\": {";
+
+    for(size_t i = 0; i < 20; ++i) {
+      if(i) json += ", ";
+      json += "\"" + std::to_string(205705993 + i) + "\": \"" + text(rng, 2) + "\"";
+    }
+
+    json += "}, \"events\": {";
+    for(size_t i = 0; i < events; ++i) {
+      const std::string id = std::to_string(138586341 + i * 4);
+
+      if(i) json += ",";
+      json += "\n\"" + id + "\": {\"description\": null, \"id\": " + id +
+        ", \"logo\": " + (rng.below(3) ? "null" : "\"/images/UE0AAAAACEKo6QAAAAVDSVRN\"") +
+        ", \"name\": \"" + text(rng, 3) + "\", \"subTopicIds\": [337184262, 337184283, 337184275]"
+        ", \"subjectCode\": null, \"subtitle\": null, \"topicIds\": [324846099, " +
+        std::to_string(107888604 + rng.below(1000)) + "]}";
+    }
+
+    json += "}, \"performances\": [";
+    for(size_t i = 0; i < events; ++i) {
+      if(i) json += ",";
+      json += "\n{\"eventId\": " + std::to_string(138586341 + i * 4) +
+        ", \"id\": " + std::to_string(339887544 + i) + ", \"logo\": null, \"name\": null, \"prices\": [";
+
+      for(size_t j = 0, n = 1 + rng.below(4); j < n; ++j) {
+        if(j) json += ", ";
+        json += "{\"amount\": " + std::to_string(9000 + rng.below(300) * 500) +
+          ", \"audienceSubCategoryId\": 337100890, \"seatCategoryId\": " +
+          std::to_string(338937295 + j) + "}";
+      }
+
+      json += "], \"seatCategories\": [{\"areas\": [{\"areaId\": 205705999, \"blockIds\": []}"
+        ", {\"areaId\": 205705998, \"blockIds\": []}], \"seatCategoryId\": 338937295}]"
+        ", \"seatMapImage\": null, \"start\": " + std::to_string(1372701600000 + i * 86400000) +
+        ", \"venueCode\": \"PLEYEL_PLEYEL\"}";
+    }
+
+    return json + "\n]}";
+  }
+
+  std::string deep(size_t documents, size_t depth) {
+    std::string json = "[";
+
+    for(size_t i = 0; i < documents; ++i) {
+      if(i) json += ",\n";
+
+      for(size_t level = 0; level < depth; ++level) {
+        json += level % 2 ? "[" : "{\"child\": ";
+      }
+      json += std::to_string(i);
+      for(size_t level = depth; level-- > 0;) {
+        json += level % 2 ? ", 1]" : ", \"level\": " + std::to_string(level) + "}";
+      }
+    }
+
+    return json + "]";
+  }
+
+  std::string escapes(size_t strings) {
+    generator rng;
+    std::string json = "[";
+
+    for(size_t i = 0; i < strings; ++i) {
+      if(i) json += ",\n";
+      json += "\"";
+
+      for(size_t j = 0; j < 24; ++j) {
+        json += rng.pick({ "line\\n", "\\ttab", "\\\"quoted\\\"", "C:\\\\path\\\\",
+                           "\\u00fcber", "\\ud83d\\ude00", "\\/slash", "\\r\\n",
+                           "\\u0001", "plain" });
+      }
+
+      json += "\"";
+    }
+
+    return json + "]";
+  }
+
+  std::string scripts(size_t messages) {
+    generator rng;
+    std::string json = "[";
+
+    for(size_t i = 0; i < messages; ++i) {
+      if(i) json += ",\n";
+      json += "{\"id\": " + std::to_string(i) + ", \"lang\": \"" +
+        rng.pick({ "en", "el", "ru", "ar", "zh", "ja" }) + "\", \"text\": \"";
+
+      for(size_t j = 0; j < 8 + rng.below(16); ++j) {
+        if(j) json += ' ';
+        json += rng.pick({ "release", "café", "naïve", "καλημέρα", "λόγος",
+                           "привет", "данные", "مرحبا", "بيانات", "数据",
+                           "解析器", "こんにちは", "テスト", "😀", "🚀", "ok" });
+      }
+
+      json += "\"}";
+    }
+
+    return json + "]";
+  }
+
+  std::string ndjson(size_t records) {
+    generator rng;
+    std::string json;
+
+    for(size_t i = 0; i < records; ++i) {
+      json += "{\"timestamp\": \"2024-03-" + std::to_string(10 + i % 18) + "T12:" +
+        std::to_string(10 + i % 50) + ":00Z\", \"level\": \"" +
+        rng.pick({ "info", "info", "warn", "error" }) + "\", \"service\": \"" +
+        rng.pick({ "api", "auth", "billing" }) + "\", \"latency_ms\": " +
+        number(rng.unit() * 250) + ", \"status\": " + rng.pick({ "200", "200", "404", "500" }) +
+        ", \"message\": \"" + text(rng, 5) + "\", \"tags\": [\"prod\", \"eu-west-1\"]}\n";
+    }
+
+    return json;
+  }
+
+  std::vector<corpus> corpora() {
+    std::vector<corpus> result;
+    result.push_back({ "twitter", twitter(6000) });
+    result.push_back({ "canada", canada(110000) });
+    result.push_back({ "citm", citm(6000) });
+    result.push_back({ "deep", deep(2000, 500) });
+    result.push_back({ "escapes", escapes(12000) });
+    result.push_back({ "scripts", scripts(20000) });
+    result.push_back({ "ndjson", ndjson(25000), true });
+    return result;
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Standard documents for throughput benchmarks, shaped after the usual
+// public corpora (twitter.json, canada.json, citm_catalog.json) so that
+// they can be generated offline. Generation is deterministic: the same
+// build always measures the same bytes.
+namespace bench {
+  struct corpus {
+    const char* name;
+    std::string text;
+    // One document per line (NDJSON) rather than a single document
+    bool lines = false;
+  };
+
+  // Social media statuses: mixed types, many short strings, unicode escapes
+  std::string twitter(size_t statuses);
+  // Polygon coordinates: almost entirely floating-point numbers
+  std::string canada(size_t points);
+  // Event catalog: objects keyed by numeric ids, many small integers
+  std::string citm(size_t events);
+  // Arrays and objects nested hundreds of levels deep
+  std::string deep(size_t documents, size_t depth);
+  // Long strings dense with escape sequences
+  std::string escapes(size_t strings);
+  // Messages written in several scripts, as raw UTF-8 rather than escapes
+  std::string scripts(size_t messages);
+  // Log records, one per line
+  std::string ndjson(size_t records);
+
+  // The corpora above at their benchmark sizes, a few MiB each
+  std::vector<corpus> corpora();
+}
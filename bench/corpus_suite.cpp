@@ -0,0 +1,89 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+  // Runs `operation` at least three times and for about a second, then
+  // records its throughput over `bytes` per run, allocations per run, and
+  // peak heap and resident memory
+  template<typename Operation>
+  void measure(const std::string& name, size_t bytes, Operation operation) {
+    bench::reset_peak();
+    bench::reset_rss();
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t iterations = 0;
+    do {
+      operation();
+      iterations++;
+    } while(iterations < 3 || (timer.seconds() < 1 && iterations < 100));
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    bench::record(name, {
+      { "throughput", bytes * iterations / seconds / (1024 * 1024), "MB/s" },
+      { "allocations", (double)(after.count - before.count) / iterations, "allocations/document" },
+      { "peak_heap", (double)(after.peak - before.live) / (1024 * 1024), "MiB peak heap" },
+      { "peak_rss", (double)bench::peak_rss() / (1024 * 1024), "MiB peak RSS" },
+    });
+  }
+}
+
+// json::parse, json::load and to_string over the standard corpora. NDJSON
+// goes through parse_lines and load_ndjson, and is written record by record.
+BENCHMARK(corpus) {
+  const std::filesystem::path directory =
+    std::filesystem::temp_directory_path() / "json-bench-corpus";
+  std::filesystem::create_directories(directory);
+
+  for(const bench::corpus& corpus : bench::corpora()) {
+    const std::string name = corpus.name;
+    const std::string& text = corpus.text;
+
+    bench::record(name, {{ "size", (double)text.size() / (1024 * 1024), "MiB" }});
+
+    const std::filesystem::path path = directory / (name + ".json");
+    std::ofstream(path, std::ios::binary) << text;
+
+    if(corpus.lines) {
+      measure(name + "/parse", text.size(), [&] {
+        std::vector<json::value> records = json::parse_lines(text);
+      });
+
+      measure(name + "/load", text.size(), [&] {
+        std::vector<json::value> records = json::load_ndjson(path);
+      });
+
+      const std::vector<json::value> records = json::parse_lines(text);
+      size_t bytes = 0;
+      for(const json::value& record : records) bytes += record.to_string().size() + 1;
+
+      measure(name + "/to_string", bytes, [&] {
+        for(const json::value& record : records) std::string output = record.to_string();
+      });
+    } else {
+      measure(name + "/parse", text.size(), [&] {
+        json::value document = json::parse(text);
+      });
+
+      measure(name + "/load", text.size(), [&] {
+        json::value document = json::load(path);
+      });
+
+      const json::value document = json::parse(text);
+      const size_t bytes = document.to_string().size();
+
+      measure(name + "/to_string", bytes, [&] {
+        std::string output = document.to_string();
+      });
+    }
+
+    std::filesystem::remove(path);
+  }
+}
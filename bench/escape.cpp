@@ -0,0 +1,84 @@
+#include "bench.h"
+
+#include <json.h>
+#include <simd.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  // Strings of plain prose, with or without frequent characters that must
+  // be escaped, and with accented text
+  json::value corpus(const char* sentence, size_t count) {
+    std::vector<json::value> strings;
+    for(size_t i = 0; i < count; ++i) {
+      strings.push_back(std::string(sentence) + std::to_string(i));
+    }
+
+    return json::array(strings);
+  }
+
+  void measure(const char* name, const json::value& value,
+               const json::write_options& options = {}) {
+    const size_t iterations = 20;
+    std::string output;
+    size_t bytes = 0;
+
+    bench::timer timer;
+    for(size_t i = 0; i < iterations; ++i) {
+      output.clear();
+      json::writer(output, options).value(value);
+      bytes += output.size();
+    }
+
+    std::cout << name << ": " << bytes / timer.seconds() / (1024 * 1024) << " MB/s\n";
+  }
+}
+
+BENCHMARK(string_escaping) {
+  const char* clean =
+    "The quick brown fox jumps over the lazy dog while the committee reviews "
+    "the quarterly report and schedules the next release for early spring ";
+  const char* heavy =
+    "line one\n\t\"quoted\" value with C:\\path\\to\\file\r\nline two\n\t\"again\" ";
+  const char* accented =
+    "Le cœur déçu mais l'âme plutôt naïve, Louÿs rêva de crapaüter en "
+    "canoë au delà des îles, près du mälströn où brûlent les novæ ";
+
+  const json::value clean_strings = corpus(clean, 50000);
+  const json::value heavy_strings = corpus(heavy, 50000);
+  const json::value accented_strings = corpus(accented, 50000);
+
+  // Scanning alone, over the concatenated text
+  const std::string text = clean_strings.to_string();
+  const std::pair<const char*, json::simd::isa> targets[] = {
+    { "scalar", json::simd::isa::scalar },
+    { "sse2", json::simd::isa::sse2 },
+    { "avx2", json::simd::isa::avx2 },
+  };
+
+  for(const auto& [name, target] : targets) {
+    if(target > json::simd::detect()) continue;
+
+    const char* begin = text.data() + 1;
+    const char* end = text.data() + text.size();
+    size_t found = 0;
+
+    bench::timer timer;
+    for(int i = 0; i < 20; ++i) {
+      for(const char* cursor = begin; cursor < end; ++cursor) {
+        cursor = json::simd::find_escape(cursor, end, false, target);
+        found++;
+      }
+    }
+
+    std::cout << "find_escape " << name << ": "
+              << text.size() * 20 / timer.seconds() / (1024 * 1024)
+              << " MB/s (" << found / 20 << " stops)\n";
+  }
+
+  measure("writer, escape-free", clean_strings);
+  measure("writer, escape-heavy", heavy_strings);
+  measure("writer, accented", accented_strings);
+  measure("writer, accented with escape_unicode", accented_strings,
+          { .escape_unicode = true });
+}
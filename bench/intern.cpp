@@ -0,0 +1,90 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  const char* keys[] = {
+    "customer_identifier", "account_reference", "created_timestamp",
+    "updated_timestamp", "shipping_address", "billing_address",
+    "preferred_language", "marketing_consent", "loyalty_program_tier",
+    "last_order_number", "average_order_value", "lifetime_order_count",
+    "support_ticket_count", "referral_source", "subscription_status",
+    "payment_method_type", "default_currency", "time_zone_name",
+    "email_verification", "phone_verification",
+  };
+
+  // An API response: an array of records that all have the same 20 keys
+  std::string records(size_t count) {
+    std::string text = "[";
+
+    for(size_t i = 0; i < count; ++i) {
+      text += i ? ",{" : "{";
+      for(size_t k = 0; k < std::size(keys); ++k) {
+        text += (k ? ",\"" : "\"") + std::string(keys[k]) + "\": " + std::to_string(i + k);
+      }
+      text += "}";
+    }
+
+    return text + "]";
+  }
+}
+
+BENCHMARK(key_interning) {
+  const std::string text = records(5000);
+  const size_t iterations = 20;
+
+  json::symbol_table symbols;
+  const std::pair<const char*, json::parse_options> variants[] = {
+    { "without interning", {} },
+    { "with a shared symbol table", { .symbols = &symbols } },
+  };
+
+  for(const auto& [name, options] : variants) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t live = 0;
+    for(size_t i = 0; i < iterations; ++i) {
+      const size_t base = bench::allocated().live;
+      json::value value = json::parse(text, options);
+      live += bench::allocated().live - base;
+    }
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << "json::parse " << name << ": "
+              << seconds * 1e3 / iterations << " ms/parse, "
+              << (double)(after.count - before.count) / iterations
+              << " allocations/parse, " << live / iterations / 1024
+              << " KiB per tree\n";
+  }
+
+  const json::value value = json::parse(text, { .symbols = &symbols });
+  const json::symbol symbol = symbols.find("loyalty_program_tier");
+  const size_t passes = 100;
+
+  long long sum = 0;
+  bench::timer by_name;
+  for(size_t pass = 0; pass < passes; ++pass) {
+    for(const json::value& record : value.elements()) {
+      sum += record.find("loyalty_program_tier")->as_int64();
+    }
+  }
+  const double name_seconds = by_name.seconds();
+
+  bench::timer by_symbol;
+  for(size_t pass = 0; pass < passes; ++pass) {
+    for(const json::value& record : value.elements()) {
+      sum += record.find(symbol)->as_int64();
+    }
+  }
+  const double symbol_seconds = by_symbol.seconds();
+
+  const size_t lookups = passes * value.size();
+  std::cout << "find(std::string_view): " << name_seconds * 1e9 / lookups << " ns/lookup\n"
+            << "find(json::symbol): " << symbol_seconds * 1e9 / lookups
+            << " ns/lookup (checksum " << sum << ")\n";
+}
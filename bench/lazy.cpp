@@ -0,0 +1,67 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  // A 50 KB API response, most of it in a list the reader does not need
+  std::string response() {
+    std::string text = R"({"metadata": {"request_id": "c0ffee", "server": "api-7"}, "results": [)";
+
+    for(int i = 0; i < 240; ++i) {
+      if(i) text += ",";
+      text += "{\"id\": " + std::to_string(i) + ", \"name\": \"result " + std::to_string(i) +
+        "\", \"tags\": [\"x\", \"y\", \"z\"], \"owner\": {\"login\": \"user\", \"roles\": " +
+        "[\"admin\", \"dev\"], \"settings\": {\"theme\": \"dark\", \"brackets\": \"[{}]\"}}, " +
+        "\"scores\": [1.5, 2.25, 3.125, 4.0625], \"active\": true}";
+    }
+
+    return text + R"(], "paging": {"next": "/results?page=2", "size": 240}, "status": "ok", "count": 240})";
+  }
+
+  template<typename Read>
+  void measure(const char* name, const std::string& text, size_t iterations, Read read) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t checksum = 0;
+    for(size_t i = 0; i < iterations; ++i) checksum += read();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << name << ": " << seconds * 1e6 / iterations << " us/document, "
+              << text.size() * iterations / seconds / (1024 * 1024) << " MB/s, "
+              << (double)(after.count - before.count) / iterations
+              << " allocations/document (checksum " << checksum << ")\n";
+  }
+
+  // Reads four fields, three of them past the large array
+  template<typename Value>
+  size_t sparse(const Value& json) {
+    return ((std::string)json["metadata"]["request_id"]).size() +
+      ((std::string)json["paging"]["next"]).size() +
+      ((std::string)json["status"]).size() + (int)json["count"];
+  }
+}
+
+BENCHMARK(lazy_sparse_access) {
+  const std::string text = response();
+  const size_t iterations = 2000;
+
+  std::cout << "document of " << text.size() / 1024 << " KiB\n";
+
+  measure("json::parse", text, iterations, [&] {
+    return sparse(json::parse(text));
+  });
+
+  json::document document;
+  measure("json::document", text, iterations, [&] {
+    return sparse(document.parse(text));
+  });
+
+  measure("json::parse_lazy", text, iterations, [&] {
+    return sparse(json::parse_lazy(text));
+  });
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+
+#include <json.h>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+  // Event records, one per line
+  std::string events(size_t count) {
+    std::string text;
+
+    for(size_t i = 0; i < count; ++i) {
+      text += "{\"event\": \"page_view\", \"user\": " + std::to_string(i % 5003) +
+        ", \"session\": \"s-" + std::to_string(i * 31) + "\", \"duration\": " +
+        std::to_string(i % 977) + ".5, \"tags\": [\"web\", \"eu-west\"]}\n";
+    }
+
+    return text;
+  }
+
+  double throughput(size_t bytes, double seconds) {
+    return bytes / seconds / (1024 * 1024);
+  }
+}
+
+BENCHMARK(ndjson_scaling) {
+  const std::string text = events(500000);
+
+  // What callers did before: split lines and parse them one at a time
+  {
+    json::document document;
+    bench::timer timer;
+
+    for(size_t begin = 0; begin < text.size();) {
+      const size_t end = text.find('\n', begin);
+      document.parse(std::string_view(text).substr(begin, end - begin));
+      begin = end + 1;
+    }
+
+    std::cout << "serial document::parse per line: "
+              << throughput(text.size(), timer.seconds()) << " MB/s\n";
+  }
+
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  for(unsigned threads = 1; threads <= cores; threads *= 2) {
+    std::atomic<size_t> count{0};
+    bench::timer timer;
+
+    json::parse_lines(text, [&](const json::value&) { count++; },
+                      { .threads = threads });
+
+    std::cout << "parse_lines callback, " << threads << " threads: "
+              << throughput(text.size(), timer.seconds()) << " MB/s\n";
+  }
+
+  bench::timer timer;
+  std::vector<json::value> records = json::parse_lines(text);
+  std::cout << "parse_lines vector, " << cores << " threads: "
+            << throughput(text.size(), timer.seconds()) << " MB/s\n";
+}
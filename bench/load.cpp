@@ -0,0 +1,70 @@
+#include "bench.h"
+
+#include <json.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+  // Records with long string fields, so that copies of the text dominate
+  std::string snapshot(size_t count) {
+    std::string text = "[\n";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",\n";
+      text += "  {\"id\": " + std::to_string(i) +
+        ", \"path\": \"/var/lib/service/objects/" + std::to_string(i * 7919) +
+        "/payload.bin\", \"owner\": \"service-account-" + std::to_string(i % 97) +
+        "\", \"description\": \"snapshot entry written by the nightly export job\"}";
+    }
+
+    return text + "\n]";
+  }
+
+  template<typename Load>
+  void measure(const char* name, size_t bytes, Load load) {
+    bench::reset_peak();
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    load();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << name << ": " << bytes / seconds / (1024 * 1024) << " MB/s, "
+              << (after.peak - before.live) / (1024 * 1024)
+              << " MB peak heap\n";
+  }
+}
+
+BENCHMARK(file_load) {
+  const std::filesystem::path path =
+    std::filesystem::temp_directory_path() / "json-bench-load.json";
+
+  size_t size;
+  {
+    const std::string text = snapshot(500000);
+    std::ofstream(path, std::ios::binary) << text;
+    size = text.size();
+  }
+
+  measure("istreambuf_iterator + json::parse", size, [&] {
+    std::fstream file(path);
+    const std::string text{std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>()};
+    json::value value = json::parse(text);
+  });
+
+  measure("json::load", size, [&] {
+    json::value value = json::load(path);
+  });
+
+  json::document document(64 * 1024 * 1024);
+  measure("json::document::load in situ", size, [&] {
+    document.load(path, { .in_situ = true });
+  });
+
+  std::filesystem::remove(path);
+}
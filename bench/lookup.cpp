@@ -0,0 +1,36 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+BENCHMARK(nested_lookup) {
+  std::string text = R"({"Image": {"Width": 800, "Height": 600, "Title": "View from 15th Floor",
+    "Thumbnail": {"Url": "http://www.example.com/image/481989943", "Height": 125, "Width": 100},
+    "Animated": false, "IDs": [)";
+
+  // A large sibling array makes copies of the enclosing object expensive
+  for(int i = 0; i < 1000; ++i) {
+    text += (i ? ", " : "") + std::to_string(i);
+  }
+  text += "]}}";
+
+  const json::value json = json::parse(text);
+  const size_t iterations = 100000;
+
+  const auto before = bench::allocated();
+  bench::timer timer;
+
+  size_t length = 0;
+  for(size_t i = 0; i < iterations; ++i) {
+    length += json["Image"]["Thumbnail"]["Url"].size();
+  }
+
+  const double seconds = timer.seconds();
+  const auto after = bench::allocated();
+
+  std::cout << "json[\"Image\"][\"Thumbnail\"][\"Url\"]: "
+            << seconds * 1e9 / iterations << " ns/lookup, "
+            << (double)(after.count - before.count) / iterations
+            << " allocations/lookup (checksum " << length << ")\n";
+}
@@ -0,0 +1,204 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+  bench::allocations counters;
+
+  struct entry {
+    const char* name;
+    void (*run)();
+  };
+
+  std::vector<entry>& registry() {
+    static std::vector<entry> entries;
+    return entries;
+  }
+
+  struct measurement {
+    std::string name;
+    std::vector<bench::metric> metrics;
+  };
+
+  std::vector<measurement> measurements;
+
+  // Every allocation carries a header recording its size and offset, so
+  // that frees can be subtracted from the live byte count.
+  constexpr size_t header = alignof(std::max_align_t);
+}
+
+namespace {
+  void* allocate(size_t size, size_t alignment) {
+    const size_t offset = std::max(header, alignment);
+    char* block = (char*)std::aligned_alloc(alignment,
+      (size + offset + alignment - 1) / alignment * alignment);
+    if(!block) throw std::bad_alloc();
+
+    std::memcpy(block + offset - header, &size, sizeof(size));
+    std::memcpy(block + offset - header + sizeof(size), &offset, sizeof(offset));
+    counters.count++;
+    counters.bytes += size;
+    counters.live += size;
+    counters.peak = std::max(counters.peak, counters.live);
+
+    return block + offset;
+  }
+
+  void deallocate(void* ptr) {
+    if(!ptr) return;
+
+    size_t size, offset;
+    std::memcpy(&size, (char*)ptr - header, sizeof(size));
+    std::memcpy(&offset, (char*)ptr - header + sizeof(size), sizeof(offset));
+    counters.live -= size;
+
+    std::free((char*)ptr - offset);
+  }
+}
+
+void* operator new(size_t size) {
+  return allocate(size, header);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return allocate(size, (size_t)alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+
+namespace bench {
+  allocations allocated() {
+    return counters;
+  }
+
+  void reset_peak() {
+    counters.peak = counters.live;
+  }
+
+  size_t peak_rss() {
+    #if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    for(std::string line; std::getline(status, line);) {
+      if(line.starts_with("VmHWM:")) return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+    #endif
+
+    #if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+    return usage.ru_maxrss;
+    #else
+    return usage.ru_maxrss * 1024;
+    #endif
+    #else
+    return 0;
+    #endif
+  }
+
+  void reset_rss() {
+    #if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+    #endif
+  }
+
+  void record(const std::string& name, std::initializer_list<metric> metrics) {
+    std::cout << name << ":";
+
+    for(const metric& metric : metrics) {
+      std::cout << (&metric == metrics.begin() ? " " : ", ") << metric.value
+                << " " << metric.unit;
+    }
+
+    std::cout << "\n";
+    measurements.push_back({name, metrics});
+  }
+
+  registrar::registrar(const char* name, void (*run)()) {
+    registry().push_back({name, run});
+  }
+}
+
+namespace {
+  // Writes the measurements as {"results": [{"name": ..., metric: value}]}
+  void report(const char* filename) {
+    std::ofstream output(filename);
+    json::writer writer{output};
+
+    writer.begin_object().key("results").begin_array();
+    for(const auto& [name, metrics] : measurements) {
+      writer.begin_object().key("name").value(name);
+      for(const bench::metric& metric : metrics) writer.key(metric.name).value(metric.value);
+      writer.end_object();
+    }
+    writer.end_array().end_object();
+  }
+
+  // Saves the standard corpora as files, for use with other parsers
+  void save(const char* directory) {
+    std::filesystem::create_directories(directory);
+
+    for(const bench::corpus& corpus : bench::corpora()) {
+      const std::string name = std::string(corpus.name) + (corpus.lines ? ".ndjson" : ".json");
+      std::ofstream(std::filesystem::path(directory) / name, std::ios::binary) << corpus.text;
+    }
+  }
+}
+
+// Usage: bench [--json FILE] [--corpus DIRECTORY] [BENCHMARK...]
+int main(int argc, char** argv) {
+  const char* report_file = nullptr;
+  std::vector<const char*> names;
+
+  for(int i = 1; i < argc; ++i) {
+    if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      report_file = argv[++i];
+    } else if(std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) {
+      save(argv[++i]);
+      return 0;
+    } else {
+      names.push_back(argv[i]);
+    }
+  }
+
+  for(const auto& [name, run] : registry()) {
+    bool selected = names.empty();
+    for(const char* selection : names) {
+      if(std::strcmp(selection, name) == 0) selected = true;
+    }
+
+    if(selected) {
+      std::cout << "== " << name << "\n";
+      run();
+    }
+  }
+
+  if(report_file) report(report_file);
+}
@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  // Array of small records; every record holds eight nodes
+  std::string records(size_t count, size_t& nodes) {
+    std::string text = "[";
+    nodes = 1;
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",";
+      text += "{\"id\": " + std::to_string(i) +
+        ", \"score\": " + std::to_string(i % 97) + ".5" +
+        ", \"active\": " + (i % 2 ? "true" : "false") +
+        ", \"name\": \"user" + std::to_string(i) + "\"" +
+        ", \"tags\": [\"new\", 0]}";
+      nodes += 8;
+    }
+
+    return text + "]";
+  }
+
+  // Flat array of integers
+  std::string scalars(size_t count, size_t& nodes) {
+    std::string text = "[";
+    nodes = count + 1;
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",";
+      text += std::to_string(i);
+    }
+
+    return text + "]";
+  }
+
+  void report(const char* name, const std::string& text, size_t nodes) {
+    const auto before = bench::allocated();
+    {
+      json::value document = json::parse(text);
+      const auto after = bench::allocated();
+
+      std::cout << name << ": " << nodes << " nodes, "
+                << (double)(after.live - before.live) / nodes
+                << " live bytes/node, "
+                << (double)(after.count - before.count) / nodes
+                << " allocations/node\n";
+    }
+  }
+}
+
+BENCHMARK(memory_per_node) {
+  std::cout << "sizeof(json::value): " << sizeof(json::value) << " bytes\n";
+
+  size_t nodes;
+  std::string text = scalars(1000000, nodes);
+  report("scalars", text, nodes);
+
+  text = records(200000, nodes);
+  report("records", text, nodes);
+}
@@ -0,0 +1,64 @@
+#include "bench.h"
+
+#include <json.h>
+#include <charconv>
+#include <iostream>
+#include <string>
+
+BENCHMARK(number_access) {
+  std::string text = "[";
+  for(size_t i = 0; i < 100000; ++i) {
+    if(i) text += ", ";
+    text += std::to_string(i) + "." + std::to_string(i % 1000);
+  }
+  text += "]";
+
+  const json::value numbers = json::parse(text);
+  const size_t passes = 10;
+
+  bench::timer timer;
+  double sum = 0;
+  for(size_t pass = 0; pass < passes; ++pass) {
+    for(size_t i = 0; i < numbers.size(); ++i) {
+      sum += (double)numbers[i];
+    }
+  }
+
+  std::cout << "(double)value[i]: "
+            << timer.seconds() * 1e9 / (passes * numbers.size())
+            << " ns/access (checksum " << sum << ")\n";
+}
+
+BENCHMARK(double_formatting) {
+  std::vector<double> numbers;
+  for(size_t i = 0; i < 1000000; ++i) {
+    numbers.push_back((double)(i * 7919 % 1000003) / 997 * (i % 2 ? 1e-6 : 1e6));
+  }
+
+  const auto measure = [&](const char* name, auto format) {
+    size_t bytes = 0;
+    bench::timer timer;
+    for(double number : numbers) bytes += format(number);
+
+    std::cout << name << ": " << timer.seconds() * 1e9 / numbers.size()
+              << " ns/number, " << (double)bytes / numbers.size() << " bytes/number\n";
+  };
+
+  // The formatting used before: fixed six decimals
+  measure("std::to_string", [](double number) {
+    return std::to_string(number).size();
+  });
+
+  measure("std::to_chars, 17 significant digits", [](double number) {
+    char digits[32];
+    return (size_t)(std::to_chars(digits, digits + sizeof(digits), number,
+                                  std::chars_format::general, 17).ptr - digits);
+  });
+
+  std::string output;
+  measure("json::writer, shortest round trip", [&](double number) {
+    output.clear();
+    json::writer(output).value(number);
+    return output.size();
+  });
+}
@@ -0,0 +1,48 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+  // One large array of records
+  std::string records(size_t count) {
+    std::string text = "[";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",\n";
+      text += "{\"id\": " + std::to_string(i) + ", \"name\": \"user " +
+        std::to_string(i % 7919) + "\", \"score\": " + std::to_string(i % 1000) +
+        ".25, \"active\": " + (i % 3 ? "true" : "false") +
+        ", \"tags\": [\"a\", \"b\", \"c\"], \"point\": {\"x\": 1.5, \"y\": -2}}";
+    }
+
+    return text + "]";
+  }
+
+  double throughput(size_t bytes, double seconds) {
+    return bytes / seconds / (1024 * 1024);
+  }
+}
+
+BENCHMARK(parallel_scaling) {
+  const std::string text = records(400000);
+
+  {
+    bench::timer timer;
+    json::value document = json::parse(text);
+    std::cout << "parse: " << throughput(text.size(), timer.seconds()) << " MB/s\n";
+  }
+
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  for(unsigned threads = 1;; threads = std::min(threads * 2, cores)) {
+    bench::timer timer;
+    json::value document = json::parse_parallel(text, { .threads = threads });
+
+    std::cout << "parse_parallel, " << threads << " threads: "
+              << throughput(text.size(), timer.seconds()) << " MB/s\n";
+
+    if(threads == cores) break;
+  }
+}
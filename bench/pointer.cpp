@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  std::string catalog(size_t count) {
+    std::string text = R"({"catalog": {"items": [)";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",";
+      text += "{\"id\": " + std::to_string(i) + ", \"name\": \"item " + std::to_string(i) +
+        "\", \"image\": {\"thumbnail\": {\"url\": \"http://example.com/" + std::to_string(i) +
+        ".png\", \"size\": [100, 125]}}}";
+    }
+
+    return text + R"(], "updated": "2024-01-01"}})";
+  }
+
+  template<typename Lookup>
+  void lookups(const char* name, size_t iterations, Lookup lookup) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    long long sum = 0;
+    for(size_t i = 0; i < iterations; ++i) sum += lookup();
+
+    const double seconds = timer.seconds();
+    std::cout << name << ": " << seconds * 1e9 / iterations << " ns/lookup, "
+              << (double)(bench::allocated().count - before.count) / iterations
+              << " allocations/lookup (checksum " << sum << ")\n";
+  }
+}
+
+BENCHMARK(pointer_lookup) {
+  const json::value json = json::parse(catalog(1000));
+  const size_t iterations = 1000000;
+
+  lookups("chained operator[]", iterations, [&] {
+    return json["catalog"]["items"][500]["image"]["thumbnail"]["size"][1].as_int64();
+  });
+
+  lookups("at_pointer(string)", iterations, [&] {
+    return json.at_pointer("/catalog/items/500/image/thumbnail/size/1").as_int64();
+  });
+
+  const json::path path("/catalog/items/500/image/thumbnail/size/1");
+  lookups("at_pointer(json::path)", iterations, [&] {
+    return json.at_pointer(path).as_int64();
+  });
+}
+
+BENCHMARK(pointer_selection) {
+  const std::string text = catalog(100000);
+  const std::vector<json::path> paths = {
+    json::path("/catalog/items/99999/image/thumbnail/url"),
+    json::path("/catalog/updated"),
+  };
+
+  bench::reset_peak();
+  auto before = bench::allocated();
+  bench::timer timer;
+
+  json::value tree = json::parse(text);
+  const std::string url = (std::string)tree.at_pointer(paths[0]);
+  tree = json::value();
+
+  double seconds = timer.seconds();
+  auto after = bench::allocated();
+  std::cout << "json::parse, then at_pointer: " << text.size() / seconds / (1024 * 1024)
+            << " MB/s, " << after.count - before.count << " allocations, peak heap "
+            << (after.peak - before.live) / (1024 * 1024) << " MiB\n";
+
+  bench::reset_peak();
+  before = bench::allocated();
+  timer = bench::timer();
+
+  size_t found = 0;
+  json::selector selector(paths, [&](size_t, const json::value&) { found++; });
+  json::parse_events(text, selector);
+
+  seconds = timer.seconds();
+  after = bench::allocated();
+  std::cout << "json::selector over parse_events: " << text.size() / seconds / (1024 * 1024)
+            << " MB/s, " << after.count - before.count << " allocations, peak heap "
+            << (after.peak - before.live) / 1024 << " KiB (" << found << " found)\n";
+}
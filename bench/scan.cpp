@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include <json.h>
+#include <simd.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  // Pretty-printed log records with long messages
+  std::string logs(size_t count) {
+    std::string text = "[\n";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",\n";
+      text += "  {\n    \"timestamp\": " + std::to_string(1700000000 + i) +
+        ",\n    \"level\": \"info\",\n    \"message\": \"request " +
+        std::to_string(i) + " completed after processing the upstream "
+        "response and writing the result to the cache\",\n"
+        "    \"tags\": [\"http\", \"cache\"],\n    \"ok\": true\n  }";
+    }
+
+    return text + "\n]";
+  }
+
+  double throughput(size_t bytes, double seconds) {
+    return bytes / seconds / (1024 * 1024);
+  }
+}
+
+BENCHMARK(structural_scan) {
+  const std::string text = logs(100000);
+  const size_t iterations = 20;
+
+  const std::pair<const char*, json::simd::isa> targets[] = {
+    { "scalar", json::simd::isa::scalar },
+    { "sse2", json::simd::isa::sse2 },
+    { "avx2", json::simd::isa::avx2 },
+  };
+
+  std::vector<std::uint32_t> positions;
+  for(const auto& [name, target] : targets) {
+    if(target > json::simd::detect()) continue;
+
+    bench::timer timer;
+    for(size_t i = 0; i < iterations; ++i) {
+      json::simd::index(text, positions, target);
+    }
+
+    std::cout << "index " << name << ": "
+              << throughput(text.size() * iterations, timer.seconds())
+              << " MB/s\n";
+  }
+
+  json::document document;
+  bench::timer timer;
+  for(size_t i = 0; i < iterations; ++i) {
+    document.parse(text);
+  }
+
+  std::cout << "json::document::parse: "
+            << throughput(text.size() * iterations, timer.seconds())
+            << " MB/s\n";
+}
@@ -0,0 +1,60 @@
+#include "bench.h"
+
+#include <json.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace {
+  // Nested records several levels deep
+  json::value tree(size_t count) {
+    std::string text = "[";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",";
+      text += "{\"id\": " + std::to_string(i) + ", \"user\": {\"name\": \"user " +
+        std::to_string(i) + "\", \"profile\": {\"tags\": [\"a\", \"b\", {\"deep\": [1, 2, [3, 4]]}]," +
+        " \"score\": " + std::to_string(i) + ".25}}}";
+    }
+
+    return json::parse(text + "]");
+  }
+
+  template<typename Write>
+  void measure(const char* name, size_t iterations, Write write) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t bytes = 0;
+    for(size_t i = 0; i < iterations; ++i) bytes += write();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << name << ": " << bytes / seconds / (1024 * 1024) << " MB/s, "
+              << (double)(after.count - before.count) / iterations
+              << " allocations/document\n";
+  }
+}
+
+BENCHMARK(serialize) {
+  const json::value value = tree(20000);
+  const size_t iterations = 20;
+
+  measure("value::to_string", iterations, [&] {
+    return value.to_string().size();
+  });
+
+  std::string output;
+  measure("json::writer, reused string", iterations, [&] {
+    output.clear();
+    json::writer(output).value(value);
+    return output.size();
+  });
+
+  measure("operator<< to std::ostringstream", iterations, [&] {
+    std::ostringstream stream;
+    stream << value;
+    return stream.str().size();
+  });
+}
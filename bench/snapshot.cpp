@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+  template<typename Load>
+  void measure(const std::string& name, size_t bytes, Load load) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    load();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    bench::record(name, {
+      { "size", (double)bytes / (1024 * 1024), "MiB" },
+      { "time", seconds * 1000, "ms" },
+      { "allocations", (double)(after.count - before.count), "allocations" },
+    });
+  }
+}
+
+// Reloading a reference document from text and from a snapshot
+BENCHMARK(snapshot_reload) {
+  const std::filesystem::path directory = std::filesystem::temp_directory_path();
+  const std::filesystem::path text_path = directory / "json-bench-reference.json";
+  const std::filesystem::path snapshot_path = directory / "json-bench-reference.snapshot";
+
+  size_t text_size;
+  {
+    const std::string text = bench::twitter(40000);
+    std::ofstream(text_path, std::ios::binary) << text;
+    text_size = text.size();
+
+    json::save_snapshot(json::parse(text), snapshot_path);
+  }
+
+  const size_t snapshot_size = std::filesystem::file_size(snapshot_path);
+
+  std::uint64_t total = 0;
+  measure("json::load + lookup", text_size, [&] {
+    json::value document = json::load(text_path);
+    total += document["statuses"][20000]["user"]["followers_count"].as_uint64();
+  });
+
+  measure("snapshot::load + lookup", snapshot_size, [&] {
+    json::snapshot snapshot;
+    snapshot.load(snapshot_path);
+    total += snapshot.root()["statuses"][20000]["user"]["followers_count"].as_uint64();
+  });
+
+  std::filesystem::remove(text_path);
+  std::filesystem::remove(snapshot_path);
+}
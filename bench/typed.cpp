@@ -0,0 +1,107 @@
+#include "bench.h"
+
+#include <json.h>
+#include <typed.h>
+#include <iostream>
+#include <string>
+
+namespace {
+  struct user {
+    std::string name;
+    int followers = 0;
+    bool verified = false;
+  };
+
+  struct status {
+    std::int64_t id = 0;
+    std::string text;
+    user author;
+    std::vector<std::string> tags;
+    double score = 0;
+  };
+
+  JSON_FIELDS(user, name, followers, verified)
+  JSON_FIELDS(status, id, text, author, tags, score)
+
+  // Records with some members the structs do not declare
+  std::string statuses(size_t count) {
+    std::string text = "[";
+
+    for(size_t i = 0; i < count; ++i) {
+      if(i) text += ",";
+      text += "{\"id\": " + std::to_string(1000000 + i) +
+        ", \"text\": \"status number " + std::to_string(i) + " with some text\"" +
+        ", \"lang\": \"en\", \"author\": {\"name\": \"user " + std::to_string(i) +
+        "\", \"followers\": " + std::to_string(i * 7) + ", \"verified\": false" +
+        ", \"location\": null}, \"tags\": [\"a\", \"bc\", \"def\"], \"score\": " +
+        std::to_string(i) + ".5, \"entities\": {\"urls\": [], \"mentions\": [1, 2]}}";
+    }
+
+    return text + "]";
+  }
+
+  // What converting into structs takes without parse_into
+  std::vector<status> from_tree(const json::value& tree) {
+    std::vector<status> result;
+
+    for(const json::value& element : tree.elements()) {
+      status& record = result.emplace_back();
+      record.id = element["id"].as_int64();
+      record.text = (std::string)element["text"];
+      record.author.name = (std::string)element["author"]["name"];
+      record.author.followers = (int)element["author"]["followers"];
+      record.author.verified = (bool)element["author"]["verified"];
+      record.tags = element["tags"].to_vector<std::string>();
+      record.score = element["score"].as_double();
+    }
+
+    return result;
+  }
+
+  template<typename Read>
+  void measure(const char* name, const std::string& text, size_t iterations, Read read) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t records = 0;
+    for(size_t i = 0; i < iterations; ++i) records += read().size();
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    std::cout << name << ": " << text.size() * iterations / seconds / (1024 * 1024)
+              << " MB/s, " << (double)(after.count - before.count) / records
+              << " allocations/record\n";
+  }
+}
+
+BENCHMARK(typed_conversion) {
+  const std::string text = statuses(20000);
+  const size_t iterations = 10;
+
+  measure("json::parse, then lookups", text, iterations, [&] {
+    return from_tree(json::parse(text));
+  });
+
+  json::document document;
+  measure("json::document, then lookups", text, iterations, [&] {
+    return from_tree(document.parse(text));
+  });
+
+  measure("json::parse_into", text, iterations, [&] {
+    std::vector<status> result;
+    json::parse_into(text, result);
+    return result;
+  });
+
+  std::vector<status> records;
+  json::parse_into(text, records);
+
+  const auto before = bench::allocated();
+  bench::timer timer;
+  const std::string output = json::serialize(records);
+  const double seconds = timer.seconds();
+
+  std::cout << "json::serialize: " << output.size() / seconds / (1024 * 1024)
+            << " MB/s, " << bench::allocated().count - before.count << " allocations\n";
+}
@@ -0,0 +1,57 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <simd.h>
+#include <string>
+
+namespace {
+  template<typename Operation>
+  void measure(const std::string& name, size_t bytes, Operation operation) {
+    bench::timer timer;
+
+    size_t iterations = 0;
+    do {
+      operation();
+      iterations++;
+    } while(iterations < 3 || (timer.seconds() < 1 && iterations < 1000));
+
+    bench::record(name, {
+      { "throughput", bytes * iterations / timer.seconds() / (1024 * 1024), "MB/s" },
+    });
+  }
+}
+
+// UTF-8 validation of ASCII and of mixed-script text by each instruction
+// set, and parsing mixed-script text, which validates its strings
+BENCHMARK(utf8_validation) {
+  const std::pair<const char*, json::simd::isa> targets[] = {
+    { "scalar", json::simd::isa::scalar },
+    { "sse2", json::simd::isa::sse2 },
+    { "avx2", json::simd::isa::avx2 },
+  };
+
+  const std::pair<const char*, std::string> inputs[] = {
+    { "ascii", bench::citm(6000) },
+    { "scripts", bench::scripts(20000) },
+  };
+
+  size_t valid = 0;
+  for(const auto& [input, text] : inputs) {
+    for(const auto& [name, target] : targets) {
+      if(target > json::simd::detect()) continue;
+
+      measure(std::string(input) + ", find_invalid_utf8 " + name, text.size(), [&] {
+        const char* end = text.data() + text.size();
+        valid += json::simd::find_invalid_utf8(text.data(), end, target) == end;
+      });
+    }
+
+    measure(std::string(input) + ", validate", text.size(), [&] {
+      valid += (bool)json::validate(text);
+    });
+    measure(std::string(input) + ", parse", text.size(), [&] {
+      valid += json::parse(text).size() > 0;
+    });
+  }
+}
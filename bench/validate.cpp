@@ -0,0 +1,45 @@
+#include "bench.h"
+#include "corpus.h"
+
+#include <json.h>
+#include <string>
+
+namespace {
+  template<typename Operation>
+  void measure(const std::string& name, size_t bytes, Operation operation) {
+    const auto before = bench::allocated();
+    bench::timer timer;
+
+    size_t iterations = 0;
+    do {
+      operation();
+      iterations++;
+    } while(iterations < 3 || (timer.seconds() < 1 && iterations < 100));
+
+    const double seconds = timer.seconds();
+    const auto after = bench::allocated();
+
+    bench::record(name, {
+      { "throughput", bytes * iterations / seconds / (1024 * 1024), "MB/s" },
+      { "allocations", (double)(after.count - before.count) / iterations, "allocations/document" },
+    });
+  }
+}
+
+// json::validate against a full parse over the standard corpora
+BENCHMARK(validate) {
+  for(const bench::corpus& corpus : bench::corpora()) {
+    if(corpus.lines) continue;
+
+    const std::string name = corpus.name;
+    const std::string& text = corpus.text;
+
+    size_t valid = 0;
+    measure(name + ", validate", text.size(), [&] {
+      valid += (bool)json::validate(text);
+    });
+    measure(name + ", parse", text.size(), [&] {
+      valid += json::parse(text).size() > 0;
+    });
+  }
+}
@@ -0,0 +1,642 @@
+#include "json.h"
+#include "reader.h"
+
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+namespace json {
+  namespace {
+    // Appends the low `bytes` bytes of `number`, most significant first
+    void put_big(std::string& output, std::uint64_t number, size_t bytes) {
+      for(size_t i = bytes; i-- > 0;) output.push_back((char)(number >> (i * 8)));
+    }
+
+    // Whether a double survives a round trip through single precision
+    bool fits_float(double number) {
+      if(std::isnan(number)) return true;
+      return std::fabs(number) <= FLT_MAX && (double)(float)number == number;
+    }
+
+    void put_float(std::string& output, char single, char twice, double number) {
+      if(fits_float(number)) {
+        output.push_back(single);
+        put_big(output, std::bit_cast<std::uint32_t>((float)number), 4);
+      } else {
+        output.push_back(twice);
+        put_big(output, std::bit_cast<std::uint64_t>(number), 8);
+      }
+    }
+
+    class cbor_writer {
+      std::string& output;
+
+      // Initial byte of a data item, with its argument in the fewest bytes
+      void head(unsigned major, std::uint64_t argument) {
+        const char type = (char)(major << 5);
+
+        if(argument < 24) {
+          output.push_back(type | (char)argument);
+        } else if(argument <= UINT8_MAX) {
+          output.push_back(type | 24);
+          put_big(output, argument, 1);
+        } else if(argument <= UINT16_MAX) {
+          output.push_back(type | 25);
+          put_big(output, argument, 2);
+        } else if(argument <= UINT32_MAX) {
+          output.push_back(type | 26);
+          put_big(output, argument, 4);
+        } else {
+          output.push_back(type | 27);
+          put_big(output, argument, 8);
+        }
+      }
+
+      void text(std::string_view str) {
+        head(3, str.size());
+        output += str;
+      }
+
+      public:
+        explicit cbor_writer(std::string& output) : output(output) {}
+
+        void write(const json::value& value) {
+          if(value.is_object()) {
+            head(5, value.members().size());
+            for(const auto& [key, element] : value.members()) {
+              text(key.as_string_view());
+              write(element);
+            }
+          } else if(value.is_array()) {
+            head(4, value.elements().size());
+            for(const json::value& element : value.elements()) write(element);
+          } else if(value.is_string()) {
+            text(value.as_string_view());
+          } else if(value.is_float()) {
+            put_float(output, (char)0xfa, (char)0xfb, value.as_double());
+          } else if(value.is_unsigned()) {
+            head(0, value.as_uint64());
+          } else if(value.is_integer()) {
+            const std::int64_t number = value.as_int64();
+            if(number < 0) {
+              head(1, (std::uint64_t)-(number + 1));
+            } else {
+              head(0, number);
+            }
+          } else if(value.is_bool()) {
+            output.push_back(value ? (char)0xf5 : (char)0xf4);
+          } else {
+            output.push_back((char)0xf6);
+          }
+        }
+    };
+
+    class msgpack_writer {
+      std::string& output;
+
+      // Type byte of a string, array or map: the fixed form when the length
+      // fits in its low bits, or a marker followed by the length
+      void head(std::uint64_t length, char fixed, size_t limit, char marker8,
+                char marker16, char marker32) {
+        if(length < limit) {
+          output.push_back(fixed | (char)length);
+        } else if(length <= UINT8_MAX && marker8) {
+          output.push_back(marker8);
+          put_big(output, length, 1);
+        } else if(length <= UINT16_MAX) {
+          output.push_back(marker16);
+          put_big(output, length, 2);
+        } else {
+          output.push_back(marker32);
+          put_big(output, length, 4);
+        }
+      }
+
+      void text(std::string_view str) {
+        head(str.size(), (char)0xa0, 32, (char)0xd9, (char)0xda, (char)0xdb);
+        output += str;
+      }
+
+      void integer(std::int64_t number) {
+        if(number >= 0) return unsigned_integer(number);
+
+        if(number >= -32) {
+          output.push_back((char)number);
+        } else if(number >= INT8_MIN) {
+          output.push_back((char)0xd0);
+          put_big(output, number, 1);
+        } else if(number >= INT16_MIN) {
+          output.push_back((char)0xd1);
+          put_big(output, number, 2);
+        } else if(number >= INT32_MIN) {
+          output.push_back((char)0xd2);
+          put_big(output, number, 4);
+        } else {
+          output.push_back((char)0xd3);
+          put_big(output, number, 8);
+        }
+      }
+
+      void unsigned_integer(std::uint64_t number) {
+        if(number <= 0x7f) {
+          output.push_back((char)number);
+        } else if(number <= UINT8_MAX) {
+          output.push_back((char)0xcc);
+          put_big(output, number, 1);
+        } else if(number <= UINT16_MAX) {
+          output.push_back((char)0xcd);
+          put_big(output, number, 2);
+        } else if(number <= UINT32_MAX) {
+          output.push_back((char)0xce);
+          put_big(output, number, 4);
+        } else {
+          output.push_back((char)0xcf);
+          put_big(output, number, 8);
+        }
+      }
+
+      public:
+        explicit msgpack_writer(std::string& output) : output(output) {}
+
+        void write(const json::value& value) {
+          if(value.is_object()) {
+            head(value.members().size(), (char)0x80, 16, 0, (char)0xde, (char)0xdf);
+            for(const auto& [key, element] : value.members()) {
+              text(key.as_string_view());
+              write(element);
+            }
+          } else if(value.is_array()) {
+            head(value.elements().size(), (char)0x90, 16, 0, (char)0xdc, (char)0xdd);
+            for(const json::value& element : value.elements()) write(element);
+          } else if(value.is_string()) {
+            text(value.as_string_view());
+          } else if(value.is_float()) {
+            put_float(output, (char)0xca, (char)0xcb, value.as_double());
+          } else if(value.is_unsigned()) {
+            unsigned_integer(value.as_uint64());
+          } else if(value.is_integer()) {
+            integer(value.as_int64());
+          } else if(value.is_bool()) {
+            output.push_back(value ? (char)0xc3 : (char)0xc2);
+          } else {
+            output.push_back((char)0xc0);
+          }
+        }
+    };
+
+    // Encoded bytes and the position reached in them
+    class input {
+      std::string_view data;
+      size_t index = 0;
+
+      // Elements reserved so far, by all containers
+      size_t reserved = 0;
+
+      public:
+        explicit input(std::string_view data) : data(data) {}
+
+        size_t remaining() const { return data.size() - index; }
+
+        // Capacity to reserve for a container declaring `count` elements.
+        // Every element of every container takes at least one byte of its
+        // own, so reservations are charged against a single budget of the
+        // input size: forged lengths, nested or not, never reserve more
+        // than that in total.
+        size_t capacity(std::uint64_t count) {
+          const size_t result = (size_t)std::min<std::uint64_t>(count, data.size() - reserved);
+          reserved += result;
+          return result;
+        }
+
+        bool byte(unsigned char& result) {
+          if(!remaining()) return false;
+          result = data[index++];
+          return true;
+        }
+
+        bool peek(unsigned char& result) const {
+          if(!remaining()) return false;
+          result = data[index];
+          return true;
+        }
+
+        // Reads a big-endian unsigned integer of `bytes` bytes
+        bool big(size_t bytes, std::uint64_t& result) {
+          if(remaining() < bytes) return false;
+
+          result = 0;
+          for(size_t i = 0; i < bytes; ++i) {
+            result = (result << 8) | (unsigned char)data[index++];
+          }
+
+          return true;
+        }
+
+        bool bytes(std::uint64_t count, std::string_view& result) {
+          if(remaining() < count) return false;
+
+          result = data.substr(index, count);
+          index += count;
+          return true;
+        }
+    };
+
+    // Containers open at once; deeper input is an error rather than a
+    // recursion that could overflow the stack
+    constexpr size_t max_depth = 1024;
+
+    double half_float(std::uint16_t bits) {
+      const int exponent = (bits >> 10) & 0x1f, mantissa = bits & 0x3ff;
+
+      double result;
+      if(exponent == 0) {
+        result = std::ldexp(mantissa, -24);
+      } else if(exponent != 31) {
+        result = std::ldexp(mantissa + 1024, exponent - 25);
+      } else {
+        result = mantissa ? NAN : INFINITY;
+      }
+
+      return bits & 0x8000 ? -result : result;
+    }
+
+    // Signed integers that fit in int64_t are stored as such, as by parse
+    json::value unsigned_number(std::uint64_t number) {
+      return number <= INT64_MAX ? json::value((std::int64_t)number) : json::value(number);
+    }
+
+    template<typename Handler>
+    class cbor_reader {
+      input bytes;
+      Handler& handler;
+
+      // Chunks of indefinite-length strings are joined here
+      std::string scratch;
+
+      size_t depth = 0;
+      const char* message = nullptr;
+
+      bool fail(const char* msg) {
+        message = msg;
+        return false;
+      }
+
+      bool truncated() {
+        return fail("cbor: unexpected end of input");
+      }
+
+      // The argument of an initial byte: its low bits, or the 1 to 8 bytes
+      // that follow. Indefinite lengths are reported as `indefinite`.
+      bool argument(unsigned char initial, std::uint64_t& result, bool& indefinite) {
+        const unsigned info = initial & 0x1f;
+        indefinite = false;
+
+        if(info < 24) {
+          result = info;
+          return true;
+        }
+
+        if(info <= 27) {
+          return bytes.big(size_t(1) << (info - 24), result) || truncated();
+        }
+
+        if(info == 31 && initial >> 5 >= 2 && initial >> 5 <= 5) {
+          indefinite = true;
+          return true;
+        }
+
+        return fail("cbor: invalid additional information");
+      }
+
+      // Whether the break code that ends an indefinite-length item is next
+      bool ended(bool& result) {
+        unsigned char next;
+        if(!bytes.peek(next)) return truncated();
+
+        result = next == 0xff;
+        if(result) bytes.byte(next);
+        return true;
+      }
+
+      // Byte or text string with the given initial byte
+      bool text(unsigned char initial, text_token& token) {
+        std::uint64_t length;
+        bool indefinite;
+        if(!argument(initial, length, indefinite)) return false;
+
+        if(!indefinite) {
+          if(!bytes.bytes(length, token.text)) return truncated();
+          token.input = true;
+          return true;
+        }
+
+        scratch.clear();
+        for(bool done; ended(done);) {
+          if(done) {
+            token = {scratch, false};
+            return true;
+          }
+
+          unsigned char chunk = 0;
+          bytes.byte(chunk);
+          if((chunk & 0xe0) != (initial & 0xe0) || (chunk & 0x1f) == 31) {
+            return fail("cbor: invalid string chunk");
+          }
+
+          std::string_view part;
+          if(!argument(chunk, length, indefinite)) return false;
+          if(!bytes.bytes(length, part)) return truncated();
+          scratch += part;
+        }
+
+        return false;
+      }
+
+      bool container(unsigned char initial) {
+        const bool object = initial >> 5 == 5;
+        std::uint64_t count = 0;
+        bool indefinite;
+        if(!argument(initial, count, indefinite)) return false;
+        if(++depth > max_depth) return fail("cbor: nesting too deep");
+
+        if(!(object ? handler.object_begin() : handler.array_begin())) return false;
+        if(!indefinite) handler.reserve(bytes.capacity(count));
+
+        for(std::uint64_t i = 0; indefinite || i < count; ++i) {
+          if(indefinite) {
+            bool done;
+            if(!ended(done)) return false;
+            if(done) break;
+          }
+
+          if(object) {
+            unsigned char key;
+            if(!bytes.byte(key)) return truncated();
+            if(key >> 5 != 2 && key >> 5 != 3) return fail("cbor: object keys must be strings");
+
+            text_token token;
+            if(!text(key, token) || !handler.key(token)) return false;
+          }
+
+          if(!value()) return false;
+        }
+
+        depth--;
+        return object ? handler.object_end() : handler.array_end();
+      }
+
+      bool simple(unsigned char initial) {
+        std::uint64_t bits;
+
+        switch(initial) {
+          case 0xf4: return handler.literal(json::value_type::false_literal);
+          case 0xf5: return handler.literal(json::value_type::true_literal);
+          case 0xf6:
+          case 0xf7: return handler.literal(json::value_type::null_literal);
+          case 0xf9:
+            if(!bytes.big(2, bits)) return truncated();
+            return handler.number(json::value(half_float((std::uint16_t)bits)));
+          case 0xfa:
+            if(!bytes.big(4, bits)) return truncated();
+            return handler.number(json::value((double)std::bit_cast<float>((std::uint32_t)bits)));
+          case 0xfb:
+            if(!bytes.big(8, bits)) return truncated();
+            return handler.number(json::value(std::bit_cast<double>(bits)));
+          case 0xff:
+            return fail("cbor: unexpected break");
+          default:
+            return fail("cbor: unsupported simple value");
+        }
+      }
+
+      public:
+        cbor_reader(std::string_view data, Handler& handler) :
+          bytes(data), handler(handler) {}
+
+        bool value() {
+          unsigned char initial;
+          if(!bytes.byte(initial)) return truncated();
+
+          std::uint64_t number;
+          bool indefinite;
+
+          // Tags only qualify the item that follows
+          while(initial >> 5 == 6) {
+            if(!argument(initial, number, indefinite)) return false;
+            if(!bytes.byte(initial)) return truncated();
+          }
+
+          switch(initial >> 5) {
+            case 0:
+              if(!argument(initial, number, indefinite)) return false;
+              return handler.number(unsigned_number(number));
+            case 1:
+              if(!argument(initial, number, indefinite)) return false;
+              if(number > INT64_MAX) return handler.number(json::value(-1.0 - (double)number));
+              return handler.number(json::value(-1 - (std::int64_t)number));
+            case 2:
+            case 3: {
+              text_token token;
+              return text(initial, token) && handler.string(token);
+            }
+            case 4:
+            case 5:
+              return container(initial);
+            default:
+              return simple(initial);
+          }
+        }
+
+        const char* error() const { return message; }
+    };
+
+    template<typename Handler>
+    class msgpack_reader {
+      input bytes;
+      Handler& handler;
+
+      size_t depth = 0;
+      const char* message = nullptr;
+
+      bool fail(const char* msg) {
+        message = msg;
+        return false;
+      }
+
+      bool truncated() {
+        return fail("msgpack: unexpected end of input");
+      }
+
+      bool length(size_t size, std::uint64_t& result) {
+        return bytes.big(size, result) || truncated();
+      }
+
+      bool text(std::uint64_t size, text_token& token) {
+        if(!bytes.bytes(size, token.text)) return truncated();
+        token.input = true;
+        return true;
+      }
+
+      bool string(std::uint64_t size) {
+        text_token token;
+        return text(size, token) && handler.string(token);
+      }
+
+      bool key() {
+        unsigned char type;
+        if(!bytes.byte(type)) return truncated();
+
+        std::uint64_t size;
+        if((type & 0xe0) == 0xa0) {
+          size = type & 0x1f;
+        } else if(type == 0xd9 || type == 0xc4) {
+          if(!length(1, size)) return false;
+        } else if(type == 0xda || type == 0xc5) {
+          if(!length(2, size)) return false;
+        } else if(type == 0xdb || type == 0xc6) {
+          if(!length(4, size)) return false;
+        } else {
+          return fail("msgpack: object keys must be strings");
+        }
+
+        text_token token;
+        return text(size, token) && handler.key(token);
+      }
+
+      bool container(bool object, std::uint64_t count) {
+        if(++depth > max_depth) return fail("msgpack: nesting too deep");
+        if(!(object ? handler.object_begin() : handler.array_begin())) return false;
+        handler.reserve(bytes.capacity(count));
+
+        for(std::uint64_t i = 0; i < count; ++i) {
+          if(object && !key()) return false;
+          if(!value()) return false;
+        }
+
+        depth--;
+        return object ? handler.object_end() : handler.array_end();
+      }
+
+      // Signed integer of `size` bytes
+      bool integer(size_t size) {
+        std::uint64_t bits;
+        if(!bytes.big(size, bits)) return truncated();
+
+        const unsigned shift = 64 - size * 8;
+        return handler.number(json::value((std::int64_t)(bits << shift) >> shift));
+      }
+
+      public:
+        msgpack_reader(std::string_view data, Handler& handler) :
+          bytes(data), handler(handler) {}
+
+        bool value() {
+          unsigned char type;
+          if(!bytes.byte(type)) return truncated();
+
+          if(type <= 0x7f) return handler.number(json::value((std::int64_t)type));
+          if(type >= 0xe0) return handler.number(json::value((std::int64_t)(signed char)type));
+          if((type & 0xf0) == 0x80) return container(true, type & 0x0f);
+          if((type & 0xf0) == 0x90) return container(false, type & 0x0f);
+          if((type & 0xe0) == 0xa0) return string(type & 0x1f);
+
+          std::uint64_t bits;
+          switch(type) {
+            case 0xc0: return handler.literal(json::value_type::null_literal);
+            case 0xc2: return handler.literal(json::value_type::false_literal);
+            case 0xc3: return handler.literal(json::value_type::true_literal);
+
+            // Strings and binary data
+            case 0xc4: case 0xd9: return length(1, bits) && string(bits);
+            case 0xc5: case 0xda: return length(2, bits) && string(bits);
+            case 0xc6: case 0xdb: return length(4, bits) && string(bits);
+
+            case 0xca:
+              if(!bytes.big(4, bits)) return truncated();
+              return handler.number(json::value((double)std::bit_cast<float>((std::uint32_t)bits)));
+            case 0xcb:
+              if(!bytes.big(8, bits)) return truncated();
+              return handler.number(json::value(std::bit_cast<double>(bits)));
+
+            case 0xcc: return length(1, bits) && handler.number(unsigned_number(bits));
+            case 0xcd: return length(2, bits) && handler.number(unsigned_number(bits));
+            case 0xce: return length(4, bits) && handler.number(unsigned_number(bits));
+            case 0xcf: return length(8, bits) && handler.number(unsigned_number(bits));
+
+            case 0xd0: return integer(1);
+            case 0xd1: return integer(2);
+            case 0xd2: return integer(4);
+            case 0xd3: return integer(8);
+
+            case 0xdc: return length(2, bits) && container(false, bits);
+            case 0xdd: return length(4, bits) && container(false, bits);
+            case 0xde: return length(2, bits) && container(true, bits);
+            case 0xdf: return length(4, bits) && container(true, bits);
+
+            case 0xc1: return fail("msgpack: invalid type");
+            default: return fail("msgpack: unsupported extension type");
+          }
+        }
+
+        const char* error() const { return message; }
+    };
+
+    template<template<typename> typename Reader>
+    json::value decode_tree(std::string_view data, const json::parse_options& options) {
+      builder build{nullptr, options};
+      tree_handler handler{build};
+      Reader<tree_handler> read{data, handler};
+
+      if(!read.value()) {
+        #ifndef NO_EXCEPTIONS
+        throw json::exception(read.error());
+        #else
+        return json::error(read.error());
+        #endif
+      }
+
+      return std::move(handler.result());
+    }
+
+    template<template<typename> typename Reader>
+    bool decode_events(std::string_view data, json::handler& handler) {
+      event_handler events{handler};
+      Reader<event_handler> read{data, events};
+
+      if(read.value()) return true;
+
+      #ifndef NO_EXCEPTIONS
+      if(read.error()) throw json::exception(read.error());
+      #endif
+      return false;
+    }
+  }
+
+  std::string to_cbor(const json::value& value) {
+    std::string output;
+    cbor_writer(output).write(value);
+    return output;
+  }
+
+  std::string to_msgpack(const json::value& value) {
+    std::string output;
+    msgpack_writer(output).write(value);
+    return output;
+  }
+
+  json::value from_cbor(std::string_view data, const json::parse_options& options) {
+    return decode_tree<cbor_reader>(data, options);
+  }
+
+  json::value from_msgpack(std::string_view data, const json::parse_options& options) {
+    return decode_tree<msgpack_reader>(data, options);
+  }
+
+  bool from_cbor(std::string_view data, json::handler& handler) {
+    return decode_events<cbor_reader>(data, handler);
+  }
+
+  bool from_msgpack(std::string_view data, json::handler& handler) {
+    return decode_events<msgpack_reader>(data, handler);
+  }
+}
@@ -0,0 +1,100 @@
+#include "file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace json {
+  mapped_file::~mapped_file() {
+    close();
+  }
+
+  #if defined(__unix__) || defined(__APPLE__)
+  const char* mapped_file::open(const std::filesystem::path& filename) {
+    close();
+
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) return "loading: cannot open file";
+
+    struct stat info;
+    const bool regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+
+    if(regular && info.st_size > 0) {
+      void* pages = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(pages != MAP_FAILED) {
+        madvise(pages, info.st_size, MADV_SEQUENTIAL);
+        ::close(fd);
+
+        data = (const char*)pages;
+        size = info.st_size;
+        mapped = true;
+        return nullptr;
+      }
+    }
+
+    // Not mappable: read it, growing the buffer for inputs of unknown size
+    size_t length = 0;
+    buffer.resize(regular && info.st_size > 0 ? info.st_size : 64 * 1024);
+
+    while(true) {
+      if(length == buffer.size()) buffer.resize(buffer.size() * 2);
+
+      const ssize_t count = ::read(fd, buffer.data() + length, buffer.size() - length);
+      if(count < 0) {
+        ::close(fd);
+        buffer = std::string();
+        return "loading: cannot read file";
+      }
+
+      if(count == 0) break;
+      length += count;
+    }
+
+    ::close(fd);
+    buffer.resize(length);
+
+    data = buffer.data();
+    size = buffer.size();
+    return nullptr;
+  }
+
+  void mapped_file::close() {
+    if(mapped) munmap(const_cast<char*>(data), size);
+
+    buffer = std::string();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+  }
+  #else
+  const char* mapped_file::open(const std::filesystem::path& filename) {
+    close();
+
+    std::ifstream file(filename, std::ios::binary);
+    if(!file) return "loading: cannot open file";
+
+    buffer.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+    if(file.bad()) return "loading: cannot read file";
+
+    data = buffer.data();
+    size = buffer.size();
+    return nullptr;
+  }
+
+  void mapped_file::close() {
+    buffer = std::string();
+    data = nullptr;
+    size = 0;
+  }
+  #endif
+
+  std::string_view mapped_file::text() const {
+    return std::string_view(data, size);
+  }
+}
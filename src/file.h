@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace json {
+  // Contents of a file for the duration of a parse. Regular files are
+  // mapped read-only and advised for sequential access; anything that
+  // cannot be mapped (pipes, special files, platforms without mmap) is read
+  // into a buffer instead.
+  class mapped_file {
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string buffer;
+
+    public:
+      mapped_file() = default;
+      ~mapped_file();
+
+      mapped_file(const mapped_file&) = delete;
+      mapped_file& operator=(const mapped_file&) = delete;
+
+      // Returns an error message, or nullptr
+      const char* open(const std::filesystem::path& filename);
+      void close();
+
+      std::string_view text() const;
+  };
+}
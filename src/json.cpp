@@ -1,73 +1,636 @@
 #include "json.h"
-#include <format>
-#include <fstream>
+#include "file.h"
+#include "reader.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <utility>
 
 namespace json {
-  class string_iterator {
-    private:
-      std::string_view text;
-      size_t index;
-    public:
-      string_iterator(const std::string_view& text);
+  string_iterator::string_iterator(const std::string_view& text) :
+    text(text), index(0), structural(nullptr), structural_end(nullptr) {}
+
+  string_iterator::string_iterator(const std::string_view& text,
+                                   std::vector<std::uint32_t>& structurals) :
+    string_iterator(text) {
+    if(text.size() >= index_threshold && text.size() < UINT32_MAX &&
+       simd::index(text, structurals)) {
+      structural = structurals.data();
+      structural_end = structural + structurals.size();
+    }
+  }
+
+  void string_iterator::skip_whitespace() {
+    if(!structural) {
+      while(available() && is_whitespace(text[index])) index++;
+      return;
+    }
+
+    while(structural != structural_end && *structural < index) structural++;
 
-      bool available() const;
-      char peek() const;
-      char next();
-  };
+    if(available() && !is_whitespace(text[index])) return;
+    index = structural != structural_end ? *structural : text.size();
+  }
 
-  json::value read_value(string_iterator& text);
+  void string_iterator::skip_to_quote() {
+    const char* begin = text.data() + index;
+    const char* end = text.data() + text.size();
 
-  string_iterator::string_iterator(const std::string_view& text) :
-    text(text), index(0) {}
+    if(structural) {
+      while(structural != structural_end && *structural < index) structural++;
+      // Unescaped quotes are indexed, so the next entry closes the string
+      if(structural != structural_end) end = text.data() + *structural;
+
+      const char* backslash = (const char*)std::memchr(begin, '\\', end - begin);
+      index = (backslash ? backslash : end) - text.data();
+      return;
+    }
+
+    index = simd::find_quote(begin, end) - text.data();
+  }
+
+  void string_iterator::skip_to_escape() {
+    const char* begin = text.data() + index;
+    const char* end = text.data() + text.size();
+
+    index = simd::find_escape(begin, end, false) - text.data();
+  }
+
+  builder::builder(std::pmr::memory_resource* arena,
+                   const json::parse_options& options) :
+    arena(arena), options(options) {}
+
+  std::pmr::memory_resource* builder::resource() const {
+    return arena ? arena : std::pmr::get_default_resource();
+  }
+
+  json::value builder::string(std::string_view str, bool input) {
+    if(input && options.in_situ && str.size() > sizeof(char*) &&
+       str.size() <= UINT32_MAX) {
+      json::value result;
+      result.type = json::value_type::string;
+      result.flags = json::value::borrowed;
+      result.length = str.size();
+      result.chars = const_cast<char*>(str.data());
+
+      return result;
+    }
+
+    if(!arena || str.size() <= sizeof(char*) || str.size() > UINT32_MAX) {
+      return json::value(std::string(str));
+    }
+
+    json::value result;
+    result.type = json::value_type::string;
+    result.flags = json::value::borrowed;
+    result.length = str.size();
+    result.chars = (char*)arena->allocate(str.size(), 1);
+    std::memcpy(result.chars, str.data(), str.size());
+
+    return result;
+  }
+
+  json::value builder::key(std::string_view str, bool input) {
+    if(!options.symbols || str.size() <= sizeof(char*) || str.size() > UINT32_MAX) {
+      return string(str, input);
+    }
+
+    const json::symbol symbol = options.symbols->intern(str);
+
+    json::value result;
+    result.type = json::value_type::string;
+    result.flags = json::value::borrowed;
+    result.length = symbol.view().size();
+    result.chars = const_cast<char*>(symbol.view().data());
+
+    return result;
+  }
+
+  // Decimal exponent of the leading significant digit of a number lexeme
+  long magnitude(std::string_view str) {
+    long exponent = 0, digits = 0;
+    bool significant = false, fraction = false;
+
+    for(size_t i = 0; i < str.size(); ++i) {
+      const char c = str[i];
+      if(c == '.') {
+        fraction = true;
+      } else if(c == 'e' || c == 'E') {
+        std::from_chars(str.data() + i + 1 + (str[i + 1] == '+'),
+                        str.data() + str.size(), exponent);
+        break;
+      } else if(c >= '0' && c <= '9') {
+        significant = significant || c != '0';
+        if(significant && !fraction) digits++;
+        if(!significant && fraction) digits--;
+      }
+    }
+
+    return exponent + digits;
+  }
+
+  json::value convert_number(std::string_view str, bool floating) {
+    const char* begin = str.data();
+    const char* end = begin + str.size();
+
+    if(!floating) {
+      std::int64_t integer;
+      if(std::from_chars(begin, end, integer).ec == std::errc()) {
+        return json::value(integer);
+      }
+
+      std::uint64_t uinteger;
+      if(std::from_chars(begin, end, uinteger).ec == std::errc()) {
+        return json::value(uinteger);
+      }
+    }
+
+    double number = 0;
+    if(std::from_chars(begin, end, number).ec == std::errc::result_out_of_range) {
+      number = magnitude(str) > 0 ? HUGE_VAL : 0.0;
+      if(!str.empty() && str[0] == '-') number = -number;
+    }
+
+    return json::value(number);
+  }
+
+  json::value builder::number(std::string_view str, bool floating) {
+    json::value result = convert_number(str, floating);
+    if(!options.number_lexemes || str.size() > UINT32_MAX) return result;
+
+    // The binary value is followed by the lexeme in a single block
+    const size_t size = sizeof(std::uint64_t) + str.size();
+    char* block = arena ?
+      (char*)arena->allocate(size, alignof(std::uint64_t)) : new char[size];
+    std::memcpy(block, result.small, sizeof(std::uint64_t));
+    std::memcpy(block + sizeof(std::uint64_t), str.data(), str.size());
+
+    result.chars = block;
+    result.length = str.size();
+    result.flags |= json::value::lexeme | (arena ? json::value::borrowed : 0);
+
+    return result;
+  }
+
+  json::value builder::array() {
+    if(!arena) return json::value(json::value_type::array);
+
+    json::value result;
+    result.type = json::value_type::array;
+    result.flags = json::value::borrowed;
+    result.array = std::pmr::polymorphic_allocator<>(arena)
+      .new_object<json::array_type>();
+
+    return result;
+  }
+
+  json::value builder::object() {
+    if(!arena) return json::value(json::value_type::object);
+
+    json::value result;
+    result.type = json::value_type::object;
+    result.flags = json::value::borrowed;
+    result.dict = std::pmr::polymorphic_allocator<>(arena)
+      .new_object<json::object_type>();
+
+    return result;
+  }
+
+  void builder::append(json::value& array, json::value&& element) {
+    array.array->push_back(std::move(element));
+  }
+
+  void builder::reserve(json::value& container, size_t size) {
+    if(container.type == json::value_type::array) {
+      container.array->reserve(size);
+    } else {
+      container.dict->reserve(size);
+    }
+  }
+
+  void builder::insert(json::value& object, json::value&& key,
+                       json::value&& element) {
+    object.dict->insert_or_assign(std::move(key), std::move(element));
+  }
+
+  object_type::object_type(const allocator_type& allocator) :
+    members(allocator), slots(allocator) {}
+
+  object_type::object_type(const object_type& other,
+                           const allocator_type& allocator) :
+    members(other.members, allocator), slots(other.slots, allocator) {}
+
+  size_t object_type::locate(std::string_view key) const {
+    json::symbol transient;
+    transient.text = key.data() ? key.data() : "";
+    transient.length = key.size();
+    transient.hash = slots.empty() ? 0 : std::hash<std::string_view>{}(key);
+
+    return locate(transient);
+  }
+
+  // Keys are compared by address first, which settles interned keys. The
+  // default symbol, which symbol_table::find returns for unknown keys,
+  // matches nothing.
+  size_t object_type::locate(const json::symbol& key) const {
+    if(key.text == nullptr) return members.size();
+
+    const auto equal = [&key](const json::value& candidate) {
+      const std::string_view text = candidate.as_string_view();
+      return text.size() == key.length &&
+        (text.data() == key.text || std::memcmp(text.data(), key.text, key.length) == 0);
+    };
+
+    if(slots.empty()) {
+      for(size_t i = 0; i < members.size(); ++i) {
+        if(equal(members[i].first)) return i;
+      }
+
+      return members.size();
+    }
+
+    const size_t mask = slots.size() - 1;
+    for(size_t slot = key.hash & mask;; slot = (slot + 1) & mask) {
+      if(!slots[slot]) return members.size();
+
+      const size_t position = slots[slot] - 1;
+      if(equal(members[position].first)) return position;
+    }
+  }
+
+  void object_type::index(size_t position) {
+    const size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view>{}(members[position].first.as_string_view()) & mask;
+
+    while(slots[slot]) slot = (slot + 1) & mask;
+    slots[slot] = position + 1;
+  }
+
+  void object_type::append(json::value&& key, json::value&& value) {
+    members.emplace_back(std::move(key), std::move(value));
+
+    if(members.size() <= index_threshold) return;
+
+    // Keep the table at most half full
+    if(members.size() * 2 > slots.size()) {
+      slots.assign(std::bit_ceil(members.size() * 4), 0);
+      for(size_t i = 0; i < members.size(); ++i) index(i);
+    } else {
+      index(members.size() - 1);
+    }
+  }
+
+  void object_type::reindex() {
+    if(members.size() <= index_threshold) {
+      slots.clear();
+      return;
+    }
+
+    std::fill(slots.begin(), slots.end(), 0);
+    for(size_t i = 0; i < members.size(); ++i) index(i);
+  }
+
+  object_type::iterator object_type::erase(const_iterator position) {
+    const size_t offset = position - members.cbegin();
+    members.erase(position);
+    reindex();
+
+    return members.begin() + offset;
+  }
+
+  size_t object_type::erase(std::string_view key) {
+    const size_t position = locate(key);
+    if(position == members.size()) return 0;
+
+    erase(members.cbegin() + position);
+    return 1;
+  }
+
+  object_type::iterator object_type::find(std::string_view key) {
+    return members.begin() + locate(key);
+  }
+
+  object_type::const_iterator object_type::find(std::string_view key) const {
+    return members.begin() + locate(key);
+  }
+
+  object_type::const_iterator object_type::find(const json::symbol& key) const {
+    return members.begin() + locate(key);
+  }
+
+  json::symbol symbol_table::intern(std::string_view key) {
+    auto existing = symbols.find(key);
+    if(existing != symbols.end()) return existing->second;
+
+    char* text = (char*)storage.allocate(key.size(), 1);
+    std::memcpy(text, key.data(), key.size());
+
+    json::symbol result;
+    result.text = text;
+    result.length = key.size();
+    result.hash = std::hash<std::string_view>{}(key);
+
+    symbols.emplace(std::string_view(text, key.size()), result);
+    return result;
+  }
+
+  json::symbol symbol_table::find(std::string_view key) const {
+    auto existing = symbols.find(key);
+    return existing != symbols.end() ? existing->second : json::symbol();
+  }
+
+  std::pair<object_type::iterator, bool> object_type::try_emplace(json::value&& key,
+                                                                  json::value&& value) {
+    const size_t position = locate(key.as_string_view());
+    if(position != members.size()) return { members.begin() + position, false };
+
+    append(std::move(key), std::move(value));
+    return { members.end() - 1, true };
+  }
+
+  object_type::iterator object_type::insert_or_assign(json::value&& key,
+                                                      json::value&& value) {
+    const size_t position = locate(key.as_string_view());
+    if(position != members.size()) {
+      members[position].second = std::move(value);
+      return members.begin() + position;
+    }
+
+    append(std::move(key), std::move(value));
+    return members.end() - 1;
+  }
+
+  value::value() :
+    type(json::value_type::undefined), flags(0), length(0), chars(nullptr) {}
+
+  value::value(const value& other) : value() {
+    copy_from(other);
+  }
+
+  value::value(value&& other) noexcept :
+    type(other.type), flags(other.flags), length(other.length) {
+    std::memcpy(small, other.small, sizeof(small));
 
-  char string_iterator::peek() const {
-    return text[index];
+    other.type = json::value_type::undefined;
+    other.flags = 0;
+    other.length = 0;
+    other.chars = nullptr;
   }
 
-  bool string_iterator::available() const {
-    return index < text.size();
+  value::~value() {
+    release();
   }
 
-  char string_iterator::next() {
-    return available() ? text[index++] : text[index];
+  value& value::operator=(const value& other) {
+    if(this != &other) {
+      value copy{other};
+      *this = std::move(copy);
+    }
+
+    return *this;
+  }
+
+  value& value::operator=(value&& other) noexcept {
+    if(this != &other) {
+      release();
+
+      type = other.type;
+      flags = other.flags;
+      length = other.length;
+      std::memcpy(small, other.small, sizeof(small));
+
+      other.type = json::value_type::undefined;
+      other.flags = 0;
+      other.length = 0;
+      other.chars = nullptr;
+    }
+
+    return *this;
+  }
+
+  void value::assign_text(std::string_view str) {
+    if(str.size() > UINT32_MAX) {
+      const char* msg = "string exceeds 4 GiB";
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      type = json::value_type::undefined;
+      str = msg;
+      #endif
+    }
+
+    length = str.size();
+
+    if(length <= sizeof(small)) {
+      flags |= embedded;
+      std::memcpy(small, str.data(), length);
+    } else {
+      chars = new char[length];
+      std::memcpy(chars, str.data(), length);
+    }
   }
 
-  value::value() : type(json::value_type::undefined) {}
+  void value::copy_from(const value& other) {
+    type = other.type;
 
-  value::value(json::value_type type) :
-    type(type) {}
+    switch(type) {
+      case json::value_type::object:
+        dict = new json::object_type(*other.dict);
+        break;
+      case json::value_type::array:
+        array = new json::array_type(*other.array);
+        break;
+      case json::value_type::integer:
+      case json::value_type::floating:
+        flags = other.flags & (unsigned_integer | lexeme);
+        length = other.length;
+
+        if(flags & lexeme) {
+          chars = new char[sizeof(std::uint64_t) + length];
+          std::memcpy(chars, other.chars, sizeof(std::uint64_t) + length);
+        } else {
+          std::memcpy(small, other.small, sizeof(small));
+        }
+        break;
+      case json::value_type::string:
+      case json::value_type::undefined:
+        assign_text(other.text());
+        break;
+      default:
+        break;
+    }
+  }
 
-  value::value(json::value_type type, std::string text) :
-    type(type), text(text) {}
+  void value::release() {
+    const json::value_type owned = (flags & (borrowed | embedded)) ?
+      json::value_type::null_literal : type;
 
-  value::value(std::unordered_map<std::string, json::value> values) :
-    type(json::value_type::object), dict(values) {}
+    switch(owned) {
+      case json::value_type::object:
+        delete dict;
+        break;
+      case json::value_type::array:
+        delete array;
+        break;
+      case json::value_type::integer:
+      case json::value_type::floating:
+        if(flags & lexeme) delete[] chars;
+        break;
+      case json::value_type::string:
+      case json::value_type::undefined:
+        delete[] chars;
+        break;
+      default:
+        break;
+    }
 
-  value::value(std::vector<json::value> values) :
-    type(json::value_type::array), array(values) {}
+    chars = nullptr;
+    flags = 0;
+    length = 0;
+  }
+
+  std::string_view value::text() const {
+    switch(type) {
+      case json::value_type::string:
+      case json::value_type::undefined:
+        return std::string_view((flags & embedded) ? small : chars, length);
+      default:
+        return std::string_view();
+    }
+  }
+
+  std::string_view value::as_string_view() const {
+    return is_string() ? text() : std::string_view();
+  }
+
+  std::uint64_t value::number_bits() const {
+    std::uint64_t bits;
+    std::memcpy(&bits, (flags & lexeme) ? chars : small, sizeof(bits));
+    return bits;
+  }
+
+  bool value::is_unsigned() const {
+    return is_integer() && (flags & unsigned_integer);
+  }
+
+  std::int64_t value::as_int64() const {
+    switch(type) {
+      case json::value_type::integer:
+        return (std::int64_t)number_bits();
+      case json::value_type::floating:
+        return (std::int64_t)as_double();
+      default:
+        return 0;
+    }
+  }
+
+  std::uint64_t value::as_uint64() const {
+    switch(type) {
+      case json::value_type::integer:
+        return number_bits();
+      case json::value_type::floating:
+        return (std::uint64_t)as_double();
+      default:
+        return 0;
+    }
+  }
+
+  double value::as_double() const {
+    switch(type) {
+      case json::value_type::integer:
+        if(flags & unsigned_integer) return (double)number_bits();
+        return (double)(std::int64_t)number_bits();
+      case json::value_type::floating:
+        return std::bit_cast<double>(number_bits());
+      default:
+        return 0;
+    }
+  }
+
+  std::string_view value::lexeme_view() const {
+    if(is_number() && (flags & lexeme)) {
+      return std::string_view(chars + sizeof(std::uint64_t), length);
+    }
+
+    return std::string_view();
+  }
+
+  value::value(json::value_type type) : value() {
+    this->type = type;
+
+    switch(type) {
+      case json::value_type::object:
+        dict = new json::object_type();
+        break;
+      case json::value_type::array:
+        array = new json::array_type();
+        break;
+      default:
+        break;
+    }
+  }
+
+  value::value(json::value_type type, std::string text) : value() {
+    if(type == json::value_type::integer || type == json::value_type::floating) {
+      *this = convert_number(text, type == json::value_type::floating);
+      return;
+    }
+
+    this->type = type;
+    assign_text(text);
+  }
+
+  value::value(std::unordered_map<std::string, json::value> values) : value() {
+    type = json::value_type::object;
+    dict = new json::object_type();
+
+    for(auto& [key, value] : values) {
+      dict->insert_or_assign(json::value(key), std::move(value));
+    }
+  }
+
+  value::value(std::vector<json::value> values) : value() {
+    type = json::value_type::array;
+    array = new json::array_type(std::make_move_iterator(values.begin()),
+                                 std::make_move_iterator(values.end()));
+  }
 
   value::value(std::string str) :
-    type(json::value_type::string), text(str) {}
+    value(json::value_type::string, std::move(str)) {}
 
   value::value(const char* str) : value(std::string{str}) {}
 
-  value::value(bool value) :
-    type(value ?
-         json::value_type::true_literal :
-         json::value_type::false_literal) {}
+  value::value(bool boolean) :
+    value(boolean ?
+          json::value_type::true_literal :
+          json::value_type::false_literal) {}
+
+  value::value(int number) : value((std::int64_t)number) {}
 
-  value::value(int value) :
-    type(json::value_type::integer), text(std::to_string(value)) {}
+  value::value(std::int64_t number) : value() {
+    type = json::value_type::integer;
+    integer = number;
+  }
+
+  value::value(std::uint64_t number) : value() {
+    type = json::value_type::integer;
+    uinteger = number;
+    if(number > INT64_MAX) flags = unsigned_integer;
+  }
 
-  value::value(double value) :
-    type(json::value_type::floating), text(std::to_string(value)) {}
+  value::value(double number) : value() {
+    type = json::value_type::floating;
+    floating = number;
+  }
 
-  std::vector<std::string> value::keys() {
+  std::vector<std::string> value::keys() const {
     std::vector<std::string> result;
 
     if(is_object()) {
-      for(auto& [key, value] : dict) {
-        result.push_back(key);
+      for(auto& [key, value] : *dict) {
+        result.emplace_back(key.as_string_view());
       }
     }
 
@@ -110,78 +673,29 @@ namespace json {
 
   size_t value::size() const {
     switch(type) {
+      case json::value_type::object:
+        return dict->size();
       case json::value_type::array:
-        return array.size();
+        return array->size();
       case json::value_type::string:
-        return ((std::string)*this).size();
-        break;
+        return length;
       default:
         return 0;
     }
   }
 
-  std::string value::to_string() const {
+  std::string value::to_string(const json::write_options& options) const {
     std::string result;
-
-    using json::value_type;
-    switch(type) {
-      case value_type::object:
-        result += "{ ";
-
-        for(size_t i = 0; const auto& [key, val] : dict) {
-          if(i++) result += ", ";
-          result += std::format("\"{}\": {}", key, val.to_string());
-        }
-
-        result += " }";
-        break;
-
-      case value_type::array:
-        result += "[";
-
-        for(size_t i = 0; const auto& val : array) {
-          result += ((i++) ? ", " : "") + val.to_string();
-        }
-
-        result += "]";
-        break;
-
-      case value_type::floating:
-      case value_type::integer:
-        result += text;
-        break;
-
-      case value_type::string:
-        result += std::format("\"{}\"", text);
-        break;
-
-      case value_type::true_literal:
-        result += "true";
-        break;
-
-      case value_type::false_literal:
-        result += "false";
-        break;
-
-      case value_type::null_literal:
-        result += "null";
-        break;
-
-      case value_type::undefined:
-        result += text;
-
-      default:
-        break;
-    }
-
+    json::writer(result, options).value(*this);
     return result;
   }
 
   value::operator int() const {
     switch(type) {
       case value_type::integer:
+        return (int)as_int64();
       case value_type::floating:
-        return std::stoi(to_string());
+        return (int)as_double();
       case value_type::false_literal: return 0;
       case value_type::true_literal: return 1;
       default: break;
@@ -194,14 +708,14 @@ namespace json {
     switch(type) {
       case value_type::integer:
       case value_type::floating:
-        return std::stod(to_string());
+        return as_double();
       default:
         return 0;
     }
   }
 
   value::operator std::string() const {
-    if(type == json::value_type::string) return text;
+    if(type == json::value_type::string) return std::string(text());
     return to_string();
   }
 
@@ -216,30 +730,148 @@ namespace json {
   }
   #endif
 
-  value value::operator[](const std::string& str) const {
-    auto index = dict.find(str);
-    if(index != dict.end()) {
-      return index->second;
+  const value& value::operator[](std::string_view key) const {
+    const value* member = find(key);
+    if(member) return *member;
+
+    static const json::value undefined;
+    return undefined;
+  }
+
+  const value& value::operator[](size_t i) const {
+    return at(i);
+  }
+
+  namespace {
+    // Result of an edit that does not apply to the type of the value
+    json::value& misuse(const char* msg) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      static thread_local json::value invalid;
+      invalid = json::error(msg);
+      return invalid;
+      #endif
+    }
+  }
+
+  value& value::operator[](std::string_view key) {
+    if(type == json::value_type::null_literal ||
+       type == json::value_type::undefined) {
+      *this = json::value(json::value_type::object);
+    }
+
+    if(!is_object()) return misuse("value is not an object");
+
+    auto index = dict->find(key);
+    if(index != dict->end()) return index->second;
+
+    return dict->try_emplace(json::value(std::string(key)),
+                             json::value(json::value_type::null_literal)).first->second;
+  }
+
+  value& value::emplace_back(json::value element) {
+    if(type == json::value_type::null_literal ||
+       type == json::value_type::undefined) {
+      *this = json::value(json::value_type::array);
     }
 
-    return value();
+    if(!is_array()) return misuse("value is not an array");
+
+    return array->emplace_back(std::move(element));
   }
 
-  value value::operator[](size_t i) const {
-    if(i < array.size()) {
-      return array[i];
+  value& value::insert_or_assign(std::string_view key, json::value element) {
+    if(type == json::value_type::null_literal ||
+       type == json::value_type::undefined) {
+      *this = json::value(json::value_type::object);
+    }
+
+    if(!is_object()) return misuse("value is not an object");
+
+    auto index = dict->find(key);
+    if(index != dict->end()) return index->second = std::move(element);
+
+    return dict->try_emplace(json::value(std::string(key)), std::move(element)).first->second;
+  }
+
+  size_t value::erase(std::string_view key) {
+    return is_object() ? dict->erase(key) : 0;
+  }
+
+  size_t value::erase(size_t i) {
+    if(!is_array() || i >= array->size()) return 0;
+
+    array->erase(array->begin() + i);
+    return 1;
+  }
+
+  void value::reserve(size_t size) {
+    if(is_array()) {
+      array->reserve(size);
+    } else if(is_object()) {
+      dict->reserve(size);
+    }
+  }
+
+  value& value::operator[](size_t i) {
+    return const_cast<value&>(std::as_const(*this).at(i));
+  }
+
+  const value& value::at(std::string_view key) const {
+    const value* member = find(key);
+    if(member) return *member;
+
+    const char* msg = "object key not found";
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    static const json::value missing = json::error(msg);
+    return missing;
+    #endif
+  }
+
+  const value& value::at(size_t i) const {
+    if(is_array() && i < array->size()) {
+      return (*array)[i];
     }
 
     const char* msg = "array index out of bounds";
     #ifndef NO_EXCEPTIONS
     throw json::exception(msg);
     #else
-    return json::error(msg);
+    static json::value out_of_bounds = json::error(msg);
+    return out_of_bounds;
     #endif
   }
 
+  const value* value::find(std::string_view key) const {
+    if(!is_object()) return nullptr;
+
+    auto index = dict->find(key);
+    return index != dict->end() ? &index->second : nullptr;
+  }
+
+  const value* value::find(const json::symbol& key) const {
+    if(!is_object()) return nullptr;
+
+    auto index = dict->find(key);
+    return index != dict->end() ? &index->second : nullptr;
+  }
+
+  const json::object_type& value::members() const {
+    static const json::object_type empty;
+    return is_object() ? *dict : empty;
+  }
+
+  const json::array_type& value::elements() const {
+    static const json::array_type empty;
+    return is_array() ? *array : empty;
+  }
+
   std::ostream& operator<<(std::ostream& stream, const json::value& value) {
-    return stream << value.to_string();
+    json::writer(stream).value(value);
+    return stream;
   }
 
   bool operator==(const json::value& value, double num) {
@@ -251,6 +883,9 @@ namespace json {
   }
 
   bool operator==(const json::value& value, int num) {
+    if(value.is_unsigned()) return num >= 0 && value.as_uint64() == (std::uint64_t)num;
+    if(value.is_integer()) return value.as_int64() == num;
+
     if(value.is_number() || value.is_bool()) {
       return (int)value == num;
     }
@@ -260,21 +895,36 @@ namespace json {
 
   bool operator==(const json::value& value, const char* str) {
     if(value.is_string()) {
-      return (std::string)value == str;
+      return value.as_string_view() == str;
     }
 
     return false;
   }
 
   bool operator==(const json::value& value, std::string str) {
-    if(value.is_string()) return (std::string)value == str;
+    if(value.is_string()) return value.as_string_view() == str;
 
     return false;
   }
 
-  std::string read_unicode(string_iterator& text) {
-    int value = 0, digits = 0;
-    std::string code;
+  value::value(std::initializer_list<json::pair> list):
+    value(json::value_type::object) {
+    for(const auto& item: list) {
+      dict->insert_or_assign(json::value(std::move(item.key)), std::move(item.value));
+    }
+  }
+
+  namespace {
+    // Output of the string decoder when strings are only checked
+    struct discard {
+      void operator+=(char) {}
+    };
+  }
+
+  // Reads the four hex digits of a \u escape, leaving text at the last one
+  const char* read_hex(string_iterator& text, int& value) {
+    int digits = 0;
+    value = 0;
 
     while(digits < 4 && text.available()) {
       const char c = text.peek();
@@ -299,405 +949,298 @@ namespace json {
           digits++;
           value = (value << 4) | (c - 'A' + 10);
           break;
-        default: {
-          #ifndef NO_EXCEPTIONS
-          throw json::exception("parsing: invalid unicode character");
-          #else
-          return "";
-          #endif
-        } break;
+        default:
+          return "parsing: invalid unicode character";
       }
 
       if(digits < 4) text.next();
     }
 
+    if(digits < 4) return "parsing: invalid unicode character";
+    return nullptr;
+  }
+
+  // Reads a \u escape, or the two of a UTF-16 surrogate pair for a code
+  // point above U+FFFF, and appends the code point to str as UTF-8
+  template<typename Output>
+  const char* read_unicode(string_iterator& text, Output& str) {
+    int value;
+    if(const char* msg = read_hex(text, value)) return msg;
+
+    if(value >= 0xDC00 && value <= 0xDFFF) return "parsing: unpaired surrogate";
+
+    if(value >= 0xD800 && value <= 0xDBFF) {
+      text.next();
+      if(text.next() != '\\' || text.next() != 'u') return "parsing: unpaired surrogate";
+
+      int low;
+      if(const char* msg = read_hex(text, low)) return msg;
+      if(low < 0xDC00 || low > 0xDFFF) return "parsing: unpaired surrogate";
+
+      value = 0x10000 + ((value - 0xD800) << 10) + (low - 0xDC00);
+    }
+
     // Encode a code point into UTF-8 binary representation
     if(value >= 0x0000 && value <= 0x007F) {
-      code += (char)value;
+      str += (char)value;
     } else if(value <= 0x07FF) {
-      code += ((0b110 << 5) | ((value >> 6) & 0b11111));
-      code += ((0b10 << 6) | ((value) & 0b111111));
+      str += ((0b110 << 5) | ((value >> 6) & 0b11111));
+      str += ((0b10 << 6) | ((value) & 0b111111));
+    } else if(value <= 0xFFFF) {
+      str += ((0b1110 << 4) | ((value >> 12) & 0b1111));
+      str += ((0b10 << 6) | ((value >> 6) & 0b111111));
+      str += ((0b10 << 6) | (value & 0b111111));
     } else {
-      code += ((0b1110 << 4) | ((value >> 12) & 0b1111));
-      code += ((0b10 << 6) | ((value >> 6) & 0b111111));
-      code += ((0b10 << 6) | (value & 0b111111));
+      str += ((0b11110 << 3) | ((value >> 18) & 0b111));
+      str += ((0b10 << 6) | ((value >> 12) & 0b111111));
+      str += ((0b10 << 6) | ((value >> 6) & 0b111111));
+      str += ((0b10 << 6) | (value & 0b111111));
     }
 
-    return code;
+    return nullptr;
   }
 
-  json::value read_string(string_iterator& text) {
-    text.next();
+  // Checks that the raw text of a string literal since `begin` is UTF-8,
+  // moving back to the first malformed byte if it is not
+  const char* check_utf8(string_iterator& text, size_t begin) {
+    const std::string_view raw = text.slice(begin);
+    const char* ascii = raw.data();
+    const char* end = ascii + raw.size();
+
+    // Most strings are short and ASCII, which is ruled out a word at a
+    // time before calling the vectorized search
+    for(std::uint64_t word; end - ascii >= 8; ascii += 8) {
+      std::memcpy(&word, ascii, 8);
+      if(word & 0x8080808080808080) break;
+    }
+    while(ascii < end && !(*ascii & 0x80)) ascii++;
+    if(ascii == end) return nullptr;
 
-    std::string str;
-    bool backslash = false, exit = false;
+    const char* invalid = simd::find_invalid_utf8(ascii, end);
 
-    while(text.available()) {
-      const char c = text.peek();
-      switch(c) {
-        case '\\':
-          if(!backslash) {
-            backslash = true;
-          }
+    if(invalid == end) return nullptr;
 
-          else str += '\\';
-          break;
-        case '"':
-          if(!backslash) exit = true;
-          break;
-        case 'b':
-          if(backslash) str += '\b';
-          break;
-        case 'f':
-          if(backslash) str += '\f';
-          break;
-        case 'n':
-          if(backslash) str += '\n';
-          break;
-        case 'r':
-          if(backslash) str += '\r';
-          break;
-        case 't':
-          if(backslash) str += '\t';
-          break;
-        case 'u':
-          if(backslash) {
-            text.next();
-            std::string unicode = read_unicode(text);
-            #ifdef NO_EXCEPTIONS
-            if(unicode.empty()) {
-              return json::error("parsing: invalid unicode character");
-            }
-            #endif
-
-            str += unicode;
-          }
+    text.rewind(begin + (invalid - raw.data()));
+    return "parsing: invalid UTF-8";
+  }
 
-          break;
-      }
+  // Reads the escape sequence following a backslash and appends the
+  // character it stands for to str
+  template<typename Output>
+  const char* read_escape(string_iterator& text, Output& str) {
+    switch(text.peek()) {
+      case '"': str += '"'; break;
+      case '\\': str += '\\'; break;
+      case '/': str += '/'; break;
+      case 'b': str += '\b'; break;
+      case 'f': str += '\f'; break;
+      case 'n': str += '\n'; break;
+      case 'r': str += '\r'; break;
+      case 't': str += '\t'; break;
+      case 'u': {
+        text.next();
+        if(const char* msg = read_unicode(text, str)) return msg;
+      } break;
+      default:
+        return "parsing: invalid escape sequence";
+    }
 
-      if(exit) break;
+    text.next();
+    return nullptr;
+  }
+
+  const char* read_text(string_iterator& text, std::pmr::string& str,
+                        text_token& token) {
+    text.next();
 
-      if(!backslash) str += c;
-      else if(c != '\\') backslash = false;
+    const size_t begin = text.position();
+    text.skip_to_quote();
 
+    if(text.available() && text.peek() == '"') {
+      if(const char* msg = check_utf8(text, begin)) return msg;
+      token = {text.slice(begin), true};
       text.next();
+      return nullptr;
     }
 
-    text.next();
-
-    return json::value(str);
-  }
+    str.assign(text.slice(begin));
 
-  bool is_digit(const char c) {
-    switch(c) {
-      case '0': case '1':
-      case '2': case '3':
-      case '4': case '5':
-      case '6': case '7':
-      case '8': case '9':
-        return true;
-      default:
-        return false;
-    }
-  }
-
-  std::string read_fractional(string_iterator& text) {
-    std::string buffer;
-    if(text.peek() == '.') {
-      buffer += text.next();
-      if(is_digit(text.peek())) {
-        do {
-          buffer += text.next();
-        } while(is_digit(text.peek()));
-      } else {
-        #ifndef NO_EXCEPTIONS
-        throw json::exception("parsing: decimal must be followed by digits");
-        #else
-        return "";
-        #endif
+    while(text.available() && text.peek() != '"') {
+      const char c = text.next();
+      if(c != '\\') {
+        str += c;
+        continue;
       }
+
+      if(const char* msg = read_escape(text, str)) return msg;
     }
 
-    return buffer;
+    if(!text.available()) return "parsing: unterminated string";
+    if(const char* msg = check_utf8(text, begin)) return msg;
+
+    token = {str, false};
+    text.next();
+    return nullptr;
   }
 
-  std::string read_exponent(string_iterator& text) {
-    std::string buffer;
-    if(text.peek() == 'e' || text.peek() == 'E') {
-      buffer += text.next();
-      if(text.peek() == '+') buffer += text.next();
-      else if(text.peek() == '-') buffer += text.next();
+  const char* read_text(string_iterator& text) {
+    text.next();
 
-      if(is_digit(text.peek())) {
-        do {
-          buffer += text.next();
-        } while(is_digit(text.peek()));
-      } else {
-        #ifndef NO_EXCEPTIONS
-        throw json::exception("parsing: exponent must be followed by digits");
-        #else
-        return "";
-        #endif
-      }
-    }
+    const size_t begin = text.position();
+    discard str;
 
-    return buffer;
-  }
+    while(true) {
+      text.skip_to_escape();
 
-  value::value(std::initializer_list<json::pair> list):
-    type(json::value_type::object) {
-    for(const auto& [key, value]: list) {
-      dict[key] = value;
+      switch(text.peek()) {
+        case '"':
+          if(const char* msg = check_utf8(text, begin)) return msg;
+          text.next();
+          return nullptr;
+        case '\\':
+          text.next();
+          if(const char* msg = read_escape(text, str)) return msg;
+          break;
+        default:
+          return text.available() ?
+            "parsing: unescaped control character in string" :
+            "parsing: unterminated string";
+      }
     }
   }
 
-  json::value read_number(string_iterator& text) {
-    std::string str;
-    json::value_type type = json::value_type::integer;
+  json::value read_tree(string_iterator& text, builder& build) {
+    tree_handler handler{build};
+    reader<tree_handler> read{text, handler, build.resource()};
 
-    if(text.peek() == '-') {
-      // Optional minus sign for numbers
-      str += text.next();
-    }
-
-    if(text.peek() == '0') {
-      str += text.next();
-    } else if(is_digit(text.peek())) {
-      do {
-        str += text.next();
-      } while(is_digit(text.peek()));
-    } else {
-      const char* msg = "parsing: invalid number";
+    if(!read.value()) {
       #ifndef NO_EXCEPTIONS
-      throw json::exception(msg);
+      throw json::exception(read.error());
       #else
-      return json::error(msg);
+      return json::error(read.error());
       #endif
     }
 
-    if(text.peek() == '.') {
-      const std::string fractional = read_fractional(text);
-
-      #ifdef NO_EXCEPTIONS
-      if(fractional.empty()) {
-        return json::error("parsing: decimal must be followed by digits");
-      }
-      #endif
-
-      type = json::value_type::floating;
-      str += fractional;
-    }
-
-    switch(text.peek()) {
-      case 'e':
-      case 'E': {
-        const std::string exponent = read_exponent(text);
-
-        #ifdef NO_EXCEPTIONS
-        if(exponent.empty()) {
-          return json::error("parsing: exponent must be followed by digits");
-        }
-        #endif
-
-        str += read_exponent(text);
-        type = json::value_type::floating;
-      } break;
-    }
-
-    return json::value(type, str);
+    return std::move(handler.result());
   }
 
-  json::value read_array(string_iterator& text) {
-    bool exit = false, ready = true;
-
-    std::vector<json::value> values;
-
-    if(text.peek() == '[') {
-      text.next();
+  json::value array(std::vector<json::value> list) {
+    return json::value(std::move(list));
+  }
 
-      while(text.available()) {
-        switch(text.peek()) {
-          case ',':
-            ready = true;
-            text.next();
-          case ' ': case '\r':
-          case '\n': case '\t':
-            break;
-          case ']':
-            exit = true;
-            break;
-          default:
-            if(!ready) {
-              const char* msg = "parsing: invalid array";
-              #ifndef NO_EXCEPTIONS
-              throw json::exception(msg);
-              #else
-              return json::error(msg);
-              #endif
-            }
-
-            break;
-        }
+  json::value error(const std::string& msg) {
+    return json::value(json::value_type::undefined, msg);
+  }
 
-        if(ready && !exit) {
-          values.push_back(read_value(text));
+  json::value parse(std::string_view text, const json::parse_options& options) {
+    std::vector<std::uint32_t> structurals;
+    string_iterator string{text, structurals};
+    builder build{nullptr, options};
 
-          #ifdef NO_EXCEPTIONS
-          if(values.back().error()) return values.back();
-          #endif
+    return read_tree(string, build);
+  }
 
-          ready = false;
-        } else {
-          text.next();
-          if(exit) break;
-        }
-      }
+  json::value load(const std::filesystem::path& filename) {
+    mapped_file file;
 
-      return json::value(values);
+    if(const char* msg = file.open(filename)) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      return json::error(msg);
+      #endif
     }
 
-    return json::value();
+    return json::parse(file.text());
   }
 
-  json::value read_object(string_iterator& text) {
-    text.next();
-
-    std::unordered_map<std::string, json::value> values;
+  bool parse_events(std::string_view text, json::handler& handler) {
+    // Not indexed, so that memory use does not grow with the input
+    string_iterator string{text};
+    event_handler events{handler};
+    reader<event_handler> read{string, events};
 
-    bool exit = false;
+    if(read.value()) return true;
 
-    std::string key;
+    #ifndef NO_EXCEPTIONS
+    if(read.error()) throw json::exception(read.error());
+    #endif
+    return false;
+  }
 
-    while(text.available()) {
-      switch(text.peek()) {
-        case '\"':
-          key = (std::string)read_string(text);
-          break;
-        case ':':
-          text.next();
-          values[key] = read_value(text);
+  json::validation validate(std::string_view text, size_t max_depth) {
+    // Not indexed, since the index is allocated
+    string_iterator string{text};
+    validator check{max_depth};
+    reader<validator, true> read{string, check};
 
-          #ifdef NO_EXCEPTIONS
-          if(values[key].error()) return values[key];
-          #endif
+    json::validation result;
 
-          key.clear();
-          break;
-        case ',':
-          text.next();
-          if(!key.empty()) {
-            const char* msg = "parsing: object key does not have value";
-            #ifndef NO_EXCEPTIONS
-            throw json::exception(msg);
-            #else
-            return json::error(msg);
-            #endif
-          }
-          break;
-        case '}':
-          exit = true;
-          break;
-        case ' ': case '\r':
-        case '\n': case '\t':
-          text.next();
-          break;
-        default:
-          const char* msg = "parsing: invalid object";
-          #ifndef NO_EXCEPTIONS
-          throw json::exception(msg);
-          #else
-          return json::error(msg);
-          #endif
-          break;
+    if(!read.value()) {
+      // Otherwise the validator stopped the reader just past a bracket
+      result = read.error() ?
+        json::validation{read.error(), read.error_offset()} :
+        json::validation{"parsing: nesting too deep", string.position() - 1};
+    } else {
+      string.skip_whitespace();
+      if(string.available()) {
+        result = {"parsing: unexpected text after value", string.position()};
       }
-
-      if(exit) break;
     }
 
-    text.next();
-    return json::value(values);
+    return result;
   }
 
-  json::value read_value(string_iterator& text) {
-    std::string buffer;
-    bool exit = false;
+  document::document(size_t capacity) :
+    buffer(new std::byte[capacity]),
+    arena(buffer.get(), capacity) {}
 
-    while(text.available()) {
-      switch(text.peek()) {
-        case '{':
-          return read_object(text);
-        case '[':
-          return read_array(text);
-        case '"':
-          return read_string(text);
-        case '-':
-        case '0': case '1':
-        case '2': case '3':
-        case '4': case '5':
-        case '6': case '7':
-        case '8': case '9':
-          return read_number(text);
-        case ' ': case '\n':
-        case '\r': case '\t':
-          break;
-        case ',':
-          exit = true;
-          break;
-        default:
-          buffer += text.peek();
-          break;
-      }
+  document::~document() = default;
 
-      text.next();
+  const json::value& document::parse(std::string_view text,
+                                     const json::parse_options& options) {
+    clear();
+    return read(text, options);
+  }
 
-      if(exit) break;
-    }
+  const json::value& document::load(const std::filesystem::path& filename,
+                                    const json::parse_options& options) {
+    clear();
 
-    std::string_view view = buffer;
-    view.remove_prefix(std::min(buffer.size(),
-                                buffer.find_first_not_of(" \t\n\r")));
-    view.remove_suffix(std::min(buffer.size(),
-                                buffer.size() - buffer.find_last_not_of(" \t\n\r") - 1));
+    if(!file) file = std::make_unique<mapped_file>();
 
-    if(view == "true") {
-      return json::value(json::value_type::true_literal, "true");
-    } else if(view == "false") {
-      return json::value(json::value_type::false_literal, "false");
-    } else if(view == "null") {
-      return json::value(json::value_type::null_literal, "null");
+    if(const char* msg = file->open(filename)) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      tree = json::error(msg);
+      return tree;
+      #endif
     }
 
-    const char* msg = "parsing: unrecognized literal";
-    #ifndef NO_EXCEPTIONS
-    throw json::exception(msg);
-    #else
-    return json::error(msg);
-    #endif
-  }
-
-  json::value array(std::vector<json::value> list) {
-    return json::value(list);
-  }
+    read(file->text(), options);
 
-  json::value error(const std::string& msg) {
-    return json::value(json::value_type::undefined, msg);
+    // Only an in-situ tree references the mapping
+    if(!options.in_situ) file->close();
+    return tree;
   }
 
-  json::value parse(std::string_view text) {
-    string_iterator string{text};
+  const json::value& document::read(std::string_view text,
+                                    const json::parse_options& options) {
+    string_iterator string{text, structurals};
+    builder build{&arena, options};
 
-    return read_value(string);
+    tree = read_tree(string, build);
+    return tree;
   }
 
-  json::value load(const std::filesystem::path& filename) {
-    std::fstream file(filename);
-
-    std::string contents{
-      std::istreambuf_iterator<char>(file),
-      std::istreambuf_iterator<char>()
-    };
+  const json::value& document::root() const {
+    return tree;
+  }
 
-    return json::parse(contents);
+  void document::clear() {
+    tree = json::value();
+    arena.release();
+    if(file) file->close();
   }
 }
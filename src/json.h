@@ -1,12 +1,20 @@
+#pragma once
+
 #include <iostream>
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
 #include <filesystem>
 
 namespace json {
-  enum class value_type {
+  enum class value_type : std::uint8_t {
     object, array, integer, floating, string,
     true_literal, false_literal, null_literal,
     undefined
@@ -20,21 +28,118 @@ namespace json {
   #endif
 
   class pair;
+  class value;
+  class builder;
+  class writer;
+  class mapped_file;
+  class object_type;
+  class symbol_table;
+  class path;
+  class lazy_value;
+  class selector;
+  class snapshot;
+  class snapshot_value;
+
+  using array_type = std::pmr::vector<json::value>;
+
+  struct parse_options {
+    // Strings and keys without escapes reference the input text instead of
+    // being copied, so the input must outlive the parsed values
+    bool in_situ = false;
+
+    // Numbers keep their source text alongside the parsed value, so that
+    // they are written back exactly as they were read
+    bool number_lexemes = false;
+
+    // Keys longer than a value's inline storage are interned in this table
+    // and reference its copy, which must outlive the parsed values
+    json::symbol_table* symbols = nullptr;
+  };
+
+  // Handle to a key interned in a json::symbol_table. Symbols of the same
+  // table are equal exactly when their text is, and carry the hash of
+  // their text so that lookups do not compute it again.
+  class symbol {
+    friend class json::symbol_table;
+    friend class json::object_type;
+
+    const char* text = nullptr;
+    std::uint32_t length = 0;
+    size_t hash = 0;
+
+    public:
+      symbol() = default;
+
+      std::string_view view() const { return std::string_view(text, length); }
+      bool operator==(const symbol& other) const { return text == other.text; }
+  };
+
+  struct write_options {
+    // Characters outside ASCII are written as \uXXXX escapes (surrogate
+    // pairs beyond the Basic Multilingual Plane); invalid UTF-8 becomes
+    // \ufffd. Otherwise text is written as UTF-8, as it is stored.
+    bool escape_unicode = false;
+  };
+
+  // A value is a type tag and a single word of payload (16 bytes in total).
+  // Literals carry no payload and numbers are stored in binary in the
+  // payload word. Strings and error messages point to a buffer of `length`
+  // bytes, or are embedded in the payload word when they fit; arrays and
+  // objects point to their container. Text payloads are therefore limited
+  // to 4 GiB. Numbers parsed with their lexeme point to a buffer holding the
+  // binary value followed by the text.
+  //
+  // A borrowed value lives in a json::document arena or references the
+  // input of an in-situ parse: its payload is never freed individually, and
+  // copying it produces an owned deep copy.
   class value {
+    friend class json::builder;
+    friend class json::writer;
+
+    static constexpr std::uint8_t borrowed = 1 << 0;
+    static constexpr std::uint8_t embedded = 1 << 1;
+    static constexpr std::uint8_t unsigned_integer = 1 << 2;
+    static constexpr std::uint8_t lexeme = 1 << 3;
+
     json::value_type type;
-    std::string text;
+    std::uint8_t flags;
+    std::uint32_t length;
 
-    std::unordered_map<std::string, json::value> dict;
-    std::vector<json::value> array;
+    union {
+      char* chars;
+      char small[sizeof(char*)];
+      std::int64_t integer;
+      std::uint64_t uinteger;
+      double floating;
+      json::array_type* array;
+      json::object_type* dict;
+    };
+
+    void assign_text(std::string_view str);
+    void copy_from(const value& other);
+    void release();
+
+    std::string_view text() const;
+
+    // Binary number, wherever it is stored
+    std::uint64_t number_bits() const;
 
     public:
       value();
+      value(const value& other);
+      value(value&& other) noexcept;
+      ~value();
+
+      value& operator=(const value& other);
+      value& operator=(value&& other) noexcept;
 
       explicit value(json::value_type type);
       explicit value(std::unordered_map<std::string, json::value> values);
       explicit value(std::vector<json::value> values);
       value(bool);
       value(int);
+      value(std::int64_t);
+      value(std::uint64_t);
       value(double);
       value(const char*);
       value(std::string str);
@@ -43,7 +148,7 @@ namespace json {
 
       value(json::value_type type, std::string text);
 
-      std::vector<std::string> keys();
+      std::vector<std::string> keys() const;
 
       bool is_object() const;
       bool is_array() const;
@@ -56,10 +161,65 @@ namespace json {
 
       size_t size() const;
 
-      std::string to_string() const;
+      std::string to_string(const json::write_options& options = {}) const;
+
+      // View of a string's contents without copying; empty for other types
+      std::string_view as_string_view() const;
+
+      // Numeric accessors; integers that do not fit in an int64_t are stored
+      // as uint64_t, and integers too large for either are stored as double
+      bool is_unsigned() const;
+      std::int64_t as_int64() const;
+      std::uint64_t as_uint64() const;
+      double as_double() const;
+
+      // Source text of a number parsed with number_lexemes; empty otherwise
+      std::string_view lexeme_view() const;
+
+      // Lookups return references into the tree, so chained accesses do not
+      // copy. A missing key yields an undefined value; an index out of
+      // bounds is an error.
+      const value& operator[](std::string_view key) const;
+      const value& operator[](size_t i) const;
+
+      // On a non-const value, a missing key is inserted as null (a null or
+      // undefined value first becomes an empty object)
+      value& operator[](std::string_view key);
+      value& operator[](size_t i);
+
+      // Editing in place. A null or undefined value first becomes an empty
+      // array or object; other types are an error. Values are moved in, so
+      // a tree built from temporaries never copies a subtree.
+      value& emplace_back(json::value element);
+      value& insert_or_assign(std::string_view key, json::value element);
+
+      // Removes a member, keeping the order of the others, or an element;
+      // returns the number removed
+      size_t erase(std::string_view key);
+      size_t erase(size_t i);
+
+      // Makes room for the elements or members of an array or object
+      void reserve(size_t size);
+
+      // Like operator[], but a missing key is an error
+      const value& at(std::string_view key) const;
+      const value& at(size_t i) const;
+
+      // Member with the given key, or nullptr if there is none
+      const value* find(std::string_view key) const;
+      const value* find(const json::symbol& key) const;
+
+      // Value at a JSON Pointer (RFC 6901) such as "/Image/IDs/0", or
+      // nullptr if there is none
+      const value* find(const json::path& path) const;
+
+      // Like find, but a missing value is an error
+      const value& at_pointer(std::string_view pointer) const;
+      const value& at_pointer(const json::path& path) const;
 
-      value operator[](const std::string&) const;
-      value operator[](size_t) const;
+      // Containers of an object or array; empty for other types
+      const json::object_type& members() const;
+      const json::array_type& elements() const;
 
       explicit operator std::string() const;
       explicit operator int() const;
@@ -75,8 +235,9 @@ namespace json {
         std::vector<T> result;
 
         if(is_array()) {
-          for(size_t i = 0; i < size(); ++i) {
-            result.push_back((T)array[i]);
+          result.reserve(array->size());
+          for(const json::value& element : *array) {
+            result.push_back((T)element);
           }
         }
 
@@ -84,14 +245,732 @@ namespace json {
       }
   };
 
+  static_assert(sizeof(json::value) == 16);
+
+  // Members of an object, stored contiguously in insertion order. Object
+  // keys are string values, so that they can be borrowed from the input or
+  // an arena just like other strings. Small objects are searched linearly;
+  // the insertion that takes an object past `index_threshold` members
+  // builds a hash index of member positions, so lookups never allocate.
+  class object_type {
+    public:
+      using member = std::pair<json::value, json::value>;
+      using allocator_type = std::pmr::polymorphic_allocator<>;
+      using iterator = std::pmr::vector<member>::iterator;
+      using const_iterator = std::pmr::vector<member>::const_iterator;
+
+      static constexpr size_t index_threshold = 16;
+
+      explicit object_type(const allocator_type& allocator = {});
+      object_type(const object_type& other, const allocator_type& allocator = {});
+      object_type& operator=(const object_type& other) = default;
+
+      size_t size() const { return members.size(); }
+      bool empty() const { return members.empty(); }
+
+      iterator begin() { return members.begin(); }
+      iterator end() { return members.end(); }
+      const_iterator begin() const { return members.begin(); }
+      const_iterator end() const { return members.end(); }
+
+      iterator find(std::string_view key);
+      const_iterator find(std::string_view key) const;
+      const_iterator find(const json::symbol& key) const;
+
+      // Appends a member unless the key is present; returns the member with
+      // the key and whether it was inserted
+      std::pair<iterator, bool> try_emplace(json::value&& key, json::value&& value);
+
+      // Appends a member, or replaces the value of the member with the key
+      // where it stands
+      iterator insert_or_assign(json::value&& key, json::value&& value);
+
+      // Removes members, keeping the order of the others. This shifts the
+      // members that follow and rebuilds the index, if any.
+      iterator erase(const_iterator position);
+      size_t erase(std::string_view key);
+
+      // Makes room for `count` members
+      void reserve(size_t count) { members.reserve(count); }
+
+    private:
+      std::pmr::vector<member> members;
+
+      // Open-addressing table of member positions plus one, zero marking an
+      // empty slot; empty until the object is large enough to need it
+      std::pmr::vector<std::uint32_t> slots;
+
+      size_t locate(std::string_view key) const;
+      size_t locate(const json::symbol& key) const;
+      void append(json::value&& key, json::value&& value);
+      void index(size_t position);
+      void reindex();
+  };
+
+  // Stores one copy of each distinct key. Passed in parse_options, it
+  // lets the documents of a batch share their keys: repeated keys are
+  // neither copied nor allocated again, and compare by address.
+  class symbol_table {
+    std::pmr::monotonic_buffer_resource storage;
+    std::pmr::unordered_map<std::string_view, json::symbol> symbols{&storage};
+
+    public:
+      symbol_table() = default;
+
+      symbol_table(const symbol_table&) = delete;
+      symbol_table& operator=(const symbol_table&) = delete;
+
+      // Symbol for the key, adding it to the table if it is new
+      json::symbol intern(std::string_view key);
+
+      // Symbol for the key, or a null symbol if it was never interned
+      json::symbol find(std::string_view key) const;
+
+      size_t size() const { return symbols.size(); }
+  };
+
+  // A JSON Pointer (RFC 6901) compiled once for repeated use: its tokens
+  // are unescaped and array indices converted up front, so that looking it
+  // up does not allocate. A malformed pointer throws json::exception (with
+  // NO_EXCEPTIONS, it yields a path that matches nothing).
+  class path {
+    friend class json::value;
+    friend class json::lazy_value;
+    friend class json::selector;
+    friend class json::snapshot_value;
+
+    struct token {
+      std::uint32_t offset;
+      std::uint32_t length;
+      // Array index, or npos if the token is not one
+      size_t index;
+    };
+
+    static constexpr size_t npos = -1;
+
+    // Unescaped tokens, back to back
+    std::string names;
+    std::vector<token> tokens;
+    const char* message = nullptr;
+
+    // Looks up the tokens from `from` on, starting at `root`
+    const json::value* find(const json::value& root, size_t from = 0) const;
+
+    public:
+      // The whole document
+      path() = default;
+      explicit path(std::string_view pointer);
+
+      size_t size() const { return tokens.size(); }
+
+      std::string_view name(size_t i) const {
+        return std::string_view(names).substr(tokens[i].offset, tokens[i].length);
+      }
+
+      // Whether token `i` can select the element `index` of an array; "-"
+      // and indices with leading zeros select none
+      bool selects(size_t i, size_t index) const { return tokens[i].index == index; }
+
+      #ifdef NO_EXCEPTIONS
+      bool error() const { return message != nullptr; }
+      #endif
+  };
+
+  // Member of an object built from an initializer list. Its fields are
+  // mutable so that they can be moved out of the list, whose elements are
+  // const.
   class pair {
     public:
-      std::string key;
-      json::value value;
-      pair(const std::string& key, const json::value& value):
-      key(key), value(value) {}
+      mutable std::string key;
+      mutable json::value value;
+      pair(std::string key, json::value value):
+      key(std::move(key)), value(std::move(value)) {}
   };
 
+  // Owns the parse tree of a document in a single arena. Nodes, containers
+  // and strings are bump-allocated from one region and never freed
+  // individually; reusing or destroying the document releases the whole
+  // tree at once. Parses that fit in the initial capacity do not touch the
+  // heap at all.
+  class document {
+    std::unique_ptr<std::byte[]> buffer;
+    std::pmr::monotonic_buffer_resource arena;
+    json::value tree;
+
+    // Structural index of the last parse, kept to reuse its capacity
+    std::vector<std::uint32_t> structurals;
+
+    // File of the last load, kept mapped while an in-situ tree refers to it
+    std::unique_ptr<json::mapped_file> file;
+
+    const json::value& read(std::string_view text,
+                            const json::parse_options& options);
+
+    public:
+      explicit document(size_t capacity = 16 * 1024);
+      ~document();
+
+      document(const document&) = delete;
+      document& operator=(const document&) = delete;
+
+      const json::value& parse(std::string_view text,
+                               const json::parse_options& options = {});
+      // Parses a file straight from its mapped pages. With in_situ, the
+      // tree references the mapping, which stays open until the next parse.
+      const json::value& load(const std::filesystem::path& filename,
+                              const json::parse_options& options = {});
+
+      const json::value& root() const;
+      void clear();
+  };
+
+  // Serializes JSON in a single pass, either from a value or incrementally
+  // from calls that mirror its structure:
+  //
+  //   writer.begin_object().key("ids").begin_array().value(1).value(2)
+  //         .end_array().end_object();
+  //
+  // Output goes straight into a string, which can be reused across
+  // documents, or is buffered and handed to a stream, a file descriptor or
+  // a callback in large blocks. The buffer is flushed when the writer is
+  // destroyed, but errors are then ignored: call flush() to see them.
+  class writer {
+    std::string buffer;
+    std::string* output;
+    std::function<void(std::string_view)> drain;
+    json::write_options options;
+
+    // Open containers, as '{' or '['
+    std::string stack;
+    bool first = true;
+    bool after_key = false;
+
+    void separate();
+    void put(std::string_view text);
+    void put(char c);
+    void string(std::string_view str);
+    const char* escape(const char* begin, const char* end);
+    void number(std::int64_t number);
+    void number(std::uint64_t number);
+    void number(double number);
+    void write(const json::value& value);
+
+    public:
+      explicit writer(std::string& output, const json::write_options& options = {});
+      explicit writer(std::ostream& stream, const json::write_options& options = {});
+      // A POSIX file descriptor
+      explicit writer(int fd, const json::write_options& options = {});
+      explicit writer(std::function<void(std::string_view)> callback,
+                      const json::write_options& options = {});
+      ~writer();
+
+      writer(const writer&) = delete;
+      writer& operator=(const writer&) = delete;
+
+      // Ending a container other than the innermost open one throws
+      // json::exception (and writes nothing with NO_EXCEPTIONS)
+      writer& begin_object();
+      writer& end_object();
+      writer& begin_array();
+      writer& end_array();
+      writer& key(std::string_view key);
+
+      // Writes a whole tree
+      writer& value(const json::value& value);
+
+      writer& value(std::string_view str);
+      writer& value(const std::string& str);
+      writer& value(const char* str);
+      writer& value(bool boolean);
+      writer& value(int number);
+      writer& value(std::int64_t number);
+      writer& value(std::uint64_t number);
+      writer& value(double number);
+      writer& null();
+
+      // Hands buffered output to the sink, throwing what the sink throws
+      // (json::exception when a file descriptor cannot be written)
+      void flush();
+  };
+
+  // Receives the events of json::parse_events in document order. Every
+  // callback returns true to continue or false to stop the parse; the
+  // defaults ignore their event. Keys and strings are only valid for the
+  // duration of the callback.
+  class handler {
+    public:
+      virtual ~handler() = default;
+
+      virtual bool on_object_begin() { return true; }
+      virtual bool on_object_end() { return true; }
+      virtual bool on_array_begin() { return true; }
+      virtual bool on_array_end() { return true; }
+
+      virtual bool on_key(std::string_view) { return true; }
+      virtual bool on_string(std::string_view) { return true; }
+      virtual bool on_int64(std::int64_t) { return true; }
+      virtual bool on_uint64(std::uint64_t) { return true; }
+      virtual bool on_double(double) { return true; }
+      virtual bool on_bool(bool) { return true; }
+      virtual bool on_null() { return true; }
+  };
+
+  // Picks the values at a set of paths out of a stream of events, so that
+  // only those values are built from a document of any size. Pass it to
+  // json::parse_events or to an event-driven json::parser; `found` is
+  // called with the position of a path in `paths` and its value, which is
+  // only valid during the call. Once every path has been found the parse
+  // is stopped, and so returns false. At most 64 paths are supported.
+  class selector : public json::handler {
+    // An open container outside the selected values, with the paths that
+    // match up to it and the index of its next element
+    struct frame {
+      std::uint64_t mask;
+      size_t index;
+      bool array;
+    };
+
+    std::vector<json::path> paths;
+    std::function<void(size_t, const json::value&)> found;
+
+    std::vector<frame> stack;
+    // Paths matching the member whose key was just read
+    std::uint64_t pending = 0;
+    std::uint64_t remaining = 0;
+
+    // The value being built, as its open containers and the key of their
+    // next member, and the paths that reach it
+    std::vector<std::pair<json::value, json::value>> capture;
+    std::uint64_t captured = 0;
+    size_t capture_depth = 0;
+
+    std::uint64_t enter();
+    bool begin(json::value_type type);
+    bool end();
+    // Whether the scalar starting now is selected, and by which paths
+    bool wanted(std::uint64_t& mask);
+    bool add(std::uint64_t mask, json::value&& element);
+    bool deliver(std::uint64_t mask, size_t depth, const json::value& value);
+
+    public:
+      selector(std::vector<json::path> paths,
+               std::function<void(size_t path, const json::value& value)> found);
+
+      bool on_object_begin() override;
+      bool on_object_end() override;
+      bool on_array_begin() override;
+      bool on_array_end() override;
+
+      bool on_key(std::string_view key) override;
+      bool on_string(std::string_view str) override;
+      bool on_int64(std::int64_t number) override;
+      bool on_uint64(std::uint64_t number) override;
+      bool on_double(double number) override;
+      bool on_bool(bool boolean) override;
+      bool on_null() override;
+  };
+
+  // Parses a document that arrives in chunks, such as from a socket or a
+  // pipe. Chunks may split the input anywhere, including inside a string,
+  // a number or an escape sequence; each byte is read once. The parser
+  // either builds a value, available from root() once complete, or
+  // forwards events to a json::handler as they are read. As with parse,
+  // input after the top-level value is ignored.
+  class parser {
+    public:
+      class state;
+
+      parser();
+      explicit parser(json::handler& handler);
+      ~parser();
+
+      parser(parser&& other) noexcept;
+      parser& operator=(parser&& other) noexcept;
+
+      // Reads the next chunk of input. Returns false if a callback stopped
+      // the parse; malformed input throws json::exception (returns false
+      // with NO_EXCEPTIONS). Once stopped, later calls return false.
+      bool feed(std::string_view chunk);
+
+      // Signals the end of the input, completing a trailing number or
+      // literal. Input that ends before the top-level value is complete is
+      // malformed.
+      bool finish();
+
+      // Whether the top-level value has been read
+      bool done() const;
+
+      // The value built so far; an error value once a parse has failed
+      // with NO_EXCEPTIONS. Undefined when forwarding events.
+      json::value& root();
+
+    private:
+      std::unique_ptr<state> impl;
+
+      bool read(std::string_view chunk, bool last);
+  };
+
+  struct lazy_member;
+  template<typename Item> class lazy_range;
+
+  // A value of a document read on demand by json::parse_lazy: a view of
+  // its text, which must outlive it. Nothing is parsed until it is needed.
+  // Accessing an object or an array reads and validates its own level
+  // only; the members and elements passed over on the way are skipped by
+  // matching brackets, without being parsed or validated. Lookups scan the
+  // container again each time, so values read repeatedly are best kept
+  // rather than looked up anew, or materialized.
+  class lazy_value {
+    template<typename> friend class lazy_range;
+
+    // End of the value, except for a top-level object or array, for which
+    // it is the end of the input
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    json::value_type type = json::value_type::undefined;
+    const char* message = nullptr;
+
+    static json::lazy_value locate(const char* begin, const char* end);
+    static json::lazy_value fail(const char* msg);
+
+    // Reads the next member or element of a container, from just past its
+    // opening bracket or the previous item. Returns false at its end.
+    static bool next(const char*& position, const char* end, bool object,
+                     bool& ready, json::lazy_member& item);
+
+    public:
+      lazy_value() = default;
+
+      friend json::lazy_value parse_lazy(std::string_view text);
+
+      bool is_object() const;
+      bool is_array() const;
+      bool is_bool() const;
+      bool is_string() const;
+      bool is_number() const;
+      bool is_integer() const;
+      bool is_float() const;
+      bool is_null() const;
+
+      // Counts the members or elements, or the bytes of a string's text
+      size_t size() const;
+
+      // As on json::value: a missing key yields an undefined value and an
+      // index out of bounds is an error
+      json::lazy_value operator[](std::string_view key) const;
+      json::lazy_value operator[](size_t i) const;
+      json::lazy_value at(std::string_view key) const;
+      json::lazy_value at(size_t i) const;
+      std::optional<json::lazy_value> find(std::string_view key) const;
+      json::lazy_value at_pointer(std::string_view pointer) const;
+      json::lazy_value at_pointer(const json::path& path) const;
+
+      // Iterate in document order; empty for other types
+      json::lazy_range<json::lazy_member> members() const;
+      json::lazy_range<json::lazy_value> elements() const;
+
+      bool is_unsigned() const;
+      std::int64_t as_int64() const;
+      std::uint64_t as_uint64() const;
+      double as_double() const;
+
+      // Contents of a string as written in the input, escape sequences
+      // included; converting to std::string decodes them
+      std::string_view raw_string_view() const;
+
+      // Text of the whole value
+      std::string_view raw_json() const;
+
+      // Parses the value into a tree
+      json::value materialize() const;
+
+      explicit operator std::string() const;
+      explicit operator int() const;
+      explicit operator bool() const;
+      explicit operator double() const;
+
+      #ifdef NO_EXCEPTIONS
+      bool error() const;
+      #endif
+  };
+
+  // Keys are as written in the input, escape sequences included
+  struct lazy_member {
+    std::string_view key;
+    json::lazy_value value;
+  };
+
+  // Members or elements of a lazy value, read as the range is iterated
+  template<typename Item>
+  class lazy_range {
+    // Just past the opening bracket, and the end of the container
+    const char* first = nullptr;
+    const char* last = nullptr;
+    bool object = false;
+
+    public:
+      lazy_range() = default;
+      lazy_range(const char* first, const char* last, bool object) :
+        first(first), last(last), object(object) {}
+
+      class iterator {
+        const char* position = nullptr;
+        const char* end = nullptr;
+        bool object = false;
+        bool ready = true;
+        json::lazy_member current;
+
+        public:
+          using iterator_category = std::input_iterator_tag;
+          using value_type = Item;
+          using difference_type = std::ptrdiff_t;
+          using pointer = const Item*;
+          using reference = const Item&;
+
+          iterator() = default;
+          iterator(const char* position, const char* end, bool object) :
+            position(position), end(end), object(object) {
+            ++*this;
+          }
+
+          const Item& operator*() const {
+            if constexpr(std::is_same_v<Item, json::lazy_member>) {
+              return current;
+            } else {
+              return current.value;
+            }
+          }
+
+          const Item* operator->() const { return &**this; }
+
+          iterator& operator++() {
+            // A malformed container ends after its error value
+            if(current.value.message ||
+               !json::lazy_value::next(position, end, object, ready, current)) {
+              position = nullptr;
+            }
+
+            return *this;
+          }
+
+          bool operator==(const iterator& other) const {
+            return position == other.position;
+          }
+      };
+
+      iterator begin() const {
+        return first ? iterator(first, last, object) : iterator();
+      }
+
+      iterator end() const { return iterator(); }
+  };
+
+  // Reads a document on demand, as its values are accessed; see
+  // json::lazy_value. The text must outlive the values. Only the first
+  // character of the top-level value is examined up front.
+  json::lazy_value parse_lazy(std::string_view text);
+
+  // Entry of a snapshot tape. Numbers hold their binary value and strings
+  // their offset in the string pool. The members or elements of a
+  // container follow one another on the tape, keys and values alternately
+  // for objects; its payload holds the position of the first in its low 32
+  // bits and, for objects large enough to be indexed, the position of its
+  // sorted member index in the high 32 bits.
+  struct snapshot_node {
+    json::value_type type;
+    std::uint8_t flags;
+    std::uint16_t reserved;
+    std::uint32_t length;
+    std::uint64_t payload;
+  };
+
+  struct snapshot_member;
+  template<typename Item> class snapshot_range;
+
+  // A value of a json::snapshot: a read-only view of the mapped tape, with
+  // the accessors of json::value, valid while the snapshot is open.
+  // Nothing is parsed or allocated to read it. Array elements are reached
+  // in constant time and the members of large objects by binary search.
+  class snapshot_value {
+    friend class json::snapshot;
+    template<typename> friend class snapshot_range;
+
+    // Sections of the tape, shared by the views of a snapshot
+    struct tape {
+      const json::snapshot_node* nodes = nullptr;
+      const std::uint32_t* index = nullptr;
+      const char* pool = nullptr;
+    };
+
+    const tape* sections = nullptr;
+    const json::snapshot_node* node = nullptr;
+    const char* message = nullptr;
+
+    snapshot_value(const tape* sections, const json::snapshot_node* node) :
+      sections(sections), node(node) {}
+
+    static json::snapshot_value fail(const char* msg);
+
+    const json::snapshot_node* first() const;
+
+    public:
+      snapshot_value() = default;
+
+      bool is_object() const;
+      bool is_array() const;
+      bool is_bool() const;
+      bool is_string() const;
+      bool is_number() const;
+      bool is_integer() const;
+      bool is_float() const;
+      bool is_null() const;
+
+      size_t size() const;
+
+      // As on json::value: a missing key yields an undefined value and an
+      // index out of bounds is an error
+      json::snapshot_value operator[](std::string_view key) const;
+      json::snapshot_value operator[](size_t i) const;
+      json::snapshot_value at(std::string_view key) const;
+      json::snapshot_value at(size_t i) const;
+      std::optional<json::snapshot_value> find(std::string_view key) const;
+      json::snapshot_value at_pointer(std::string_view pointer) const;
+      json::snapshot_value at_pointer(const json::path& path) const;
+
+      // Iterate in insertion order; empty for other types
+      json::snapshot_range<json::snapshot_member> members() const;
+      json::snapshot_range<json::snapshot_value> elements() const;
+
+      std::string_view as_string_view() const;
+      bool is_unsigned() const;
+      std::int64_t as_int64() const;
+      std::uint64_t as_uint64() const;
+      double as_double() const;
+
+      // Copies the value into a tree
+      json::value materialize() const;
+      std::string to_string(const json::write_options& options = {}) const;
+
+      explicit operator std::string() const;
+      explicit operator int() const;
+      explicit operator bool() const;
+      explicit operator double() const;
+
+      #ifdef NO_EXCEPTIONS
+      bool error() const;
+      #endif
+  };
+
+  struct snapshot_member {
+    std::string_view key;
+    json::snapshot_value value;
+  };
+
+  // Members or elements of a snapshot value
+  template<typename Item>
+  class snapshot_range {
+    static constexpr size_t stride = std::is_same_v<Item, json::snapshot_member> ? 2 : 1;
+
+    const json::snapshot_value::tape* sections = nullptr;
+    const json::snapshot_node* first = nullptr;
+    size_t count = 0;
+
+    public:
+      snapshot_range() = default;
+      snapshot_range(const json::snapshot_value::tape* sections,
+                     const json::snapshot_node* first, size_t count) :
+        sections(sections), first(first), count(count) {}
+
+      class iterator {
+        const json::snapshot_value::tape* sections = nullptr;
+        const json::snapshot_node* node = nullptr;
+
+        public:
+          using iterator_category = std::forward_iterator_tag;
+          using value_type = Item;
+          using difference_type = std::ptrdiff_t;
+          using pointer = void;
+          using reference = Item;
+
+          iterator() = default;
+          iterator(const json::snapshot_value::tape* sections,
+                   const json::snapshot_node* node) :
+            sections(sections), node(node) {}
+
+          Item operator*() const {
+            if constexpr(std::is_same_v<Item, json::snapshot_member>) {
+              return { json::snapshot_value(sections, node).as_string_view(),
+                       json::snapshot_value(sections, node + 1) };
+            } else {
+              return json::snapshot_value(sections, node);
+            }
+          }
+
+          iterator& operator++() {
+            node += stride;
+            return *this;
+          }
+
+          iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
+          }
+
+          bool operator==(const iterator& other) const {
+            return node == other.node;
+          }
+      };
+
+      size_t size() const { return count; }
+      bool empty() const { return count == 0; }
+
+      iterator begin() const { return iterator(sections, first); }
+      iterator end() const { return iterator(sections, first + count * stride); }
+  };
+
+  // A document saved with json::save_snapshot, mapped back read-only. The
+  // file is checked against its header, which records the format version,
+  // its size and a checksum, so stale or damaged files are rejected; its
+  // contents are then read in place, without parsing or allocation.
+  // Snapshots are meant to be read on the kind of machine that wrote them:
+  // files written with another byte order are rejected as well.
+  class snapshot {
+    std::unique_ptr<json::mapped_file> file;
+    json::snapshot_value::tape sections;
+    const char* message = nullptr;
+
+    bool fail(const char* msg);
+    // Checks the header and checksum, then locates the sections
+    bool map(std::string_view bytes);
+
+    public:
+      snapshot();
+      ~snapshot();
+
+      snapshot(const snapshot&) = delete;
+      snapshot& operator=(const snapshot&) = delete;
+
+      // Maps a snapshot file. Returns false, and throws json::exception
+      // unless NO_EXCEPTIONS is defined, if it cannot be read or is not a
+      // valid snapshot of this version.
+      bool load(const std::filesystem::path& filename);
+
+      // Reads a snapshot already in memory, such as one returned by
+      // to_snapshot; the bytes must be 8-byte aligned and outlive it
+      bool read(std::string_view bytes);
+
+      void close();
+
+      // The top-level value; views are invalidated by close and reopening
+      json::snapshot_value root() const;
+  };
+
+  // Flattens a tree into a snapshot, held in memory or saved to a file.
+  // Equal strings are stored once. A snapshot holds at most 2^32 values.
+  [[nodiscard]] std::string to_snapshot(const json::value& value);
+  bool save_snapshot(const json::value& value, const std::filesystem::path& filename);
+
   json::value array(std::vector<json::value>);
 
   #ifdef NO_EXCEPTIONS
@@ -104,6 +983,102 @@ namespace json {
   bool operator==(const json::value& value, const char* str);
   bool operator==(const json::value& value, std::string str);
 
-  [[nodiscard]] json::value parse(std::string_view text);
+  [[nodiscard]] json::value parse(std::string_view text,
+                                  const json::parse_options& options = {});
   [[nodiscard]] json::value load(const std::filesystem::path& filename);
+
+  struct lines_options {
+    // Threads parsing records, the calling one included; 0 uses one per core
+    unsigned threads = 0;
+
+    // A symbol table cannot be shared between threads, so `symbols` is
+    // ignored
+    json::parse_options parse = {};
+  };
+
+  // Parses newline-delimited JSON (JSON Lines): one value per line, with
+  // blank lines skipped. The input is split into chunks of whole lines
+  // that are parsed in parallel, and the records are returned in order.
+  // A malformed record throws json::exception naming its line (and yields
+  // an error value in its place with NO_EXCEPTIONS).
+  [[nodiscard]] std::vector<json::value> parse_lines(
+    std::string_view text, const json::lines_options& options = {});
+  [[nodiscard]] std::vector<json::value> load_ndjson(
+    const std::filesystem::path& filename, const json::lines_options& options = {});
+
+  // As above, but each record is passed to `callback` as soon as it is
+  // parsed, from the thread that parsed it and in no particular order.
+  // Every thread parses into its own arena, so records are only valid
+  // during the call and the callback must be thread-safe.
+  void parse_lines(std::string_view text,
+                   const std::function<void(const json::value&)>& callback,
+                   const json::lines_options& options = {});
+  void load_ndjson(const std::filesystem::path& filename,
+                   const std::function<void(const json::value&)>& callback,
+                   const json::lines_options& options = {});
+
+  struct parallel_options {
+    // Threads parsing the document, the calling one included; 0 uses one
+    // per core
+    unsigned threads = 0;
+
+    // A symbol table cannot be shared between threads, so `symbols` is
+    // ignored
+    json::parse_options parse = {};
+  };
+
+  // Parses a large document whose top-level value is an array or an
+  // object on several threads. A fast scan of the text divides its
+  // elements or members into ranges, which are parsed in parallel and then
+  // joined in order into the same tree as json::parse builds. Other
+  // documents, and those too small to benefit, are parsed on the calling
+  // thread. Errors are reported as by parse.
+  [[nodiscard]] json::value parse_parallel(std::string_view text,
+                                           const json::parallel_options& options = {});
+
+  // Parses text into a stream of events instead of a tree, so nothing is
+  // allocated per value. Returns false if a callback stopped the parse.
+  // Malformed input throws json::exception (returns false with
+  // NO_EXCEPTIONS); events already delivered are not retracted.
+  bool parse_events(std::string_view text, json::handler& handler);
+
+  // Outcome of json::validate: the message of the first error, worded as
+  // parse would report it, and the offset of the byte at which it was found
+  struct validation {
+    const char* error = nullptr;
+    size_t offset = 0;
+
+    explicit operator bool() const { return error == nullptr; }
+  };
+
+  // Checks that text is a single JSON value under the exact grammar of
+  // RFC 8259, which parse relaxes: stray commas, unescaped control
+  // characters in strings, malformed UTF-8 and text after the value are
+  // errors, as are containers nested deeper than max_depth. Uses the same
+  // lexer as parse, but builds and allocates nothing, and never throws.
+  [[nodiscard]] json::validation validate(std::string_view text,
+                                          size_t max_depth = 1024);
+
+  // Binary encodings of the same data model: CBOR (RFC 8949) and
+  // MessagePack, held in a std::string of bytes. Integers take the
+  // smallest encoding that holds them, and doubles are stored as single
+  // precision when that loses nothing.
+  [[nodiscard]] std::string to_cbor(const json::value& value);
+  [[nodiscard]] std::string to_msgpack(const json::value& value);
+
+  // Decode one value; bytes after it are ignored, as text is by parse.
+  // Container lengths are known up front, so their storage is reserved
+  // once. Byte strings become strings, CBOR tags are dropped and undefined
+  // becomes null; MessagePack extension types are errors, as are
+  // containers nested more than 1024 deep. With in_situ, strings reference
+  // the input. Malformed input throws json::exception (yields an error
+  // value with NO_EXCEPTIONS).
+  [[nodiscard]] json::value from_cbor(std::string_view data,
+                                      const json::parse_options& options = {});
+  [[nodiscard]] json::value from_msgpack(std::string_view data,
+                                         const json::parse_options& options = {});
+
+  // As above, but report the value as events, like parse_events
+  bool from_cbor(std::string_view data, json::handler& handler);
+  bool from_msgpack(std::string_view data, json::handler& handler);
 }
@@ -0,0 +1,384 @@
+#include "json.h"
+#include "reader.h"
+
+namespace json {
+  namespace {
+    const char* skip_whitespace(const char* p, const char* end) {
+      while(p < end && is_whitespace(*p)) p++;
+      return p;
+    }
+
+    // End of the value starting at `begin`, found without parsing it
+    const char* skip(const char* begin, const char* end) {
+      if(begin == end) return end;
+
+      switch(*begin) {
+        case '{':
+        case '[':
+          return simd::skip_container(begin, end);
+        case '"':
+          for(const char* p = begin + 1; p < end; p += 2) {
+            p = simd::find_quote(p, end);
+            if(p == end) break;
+            if(*p == '"') return p + 1;
+          }
+          return end;
+        default:
+          while(begin < end && !is_delimiter(*begin)) begin++;
+          return begin;
+      }
+    }
+
+    // Where a member or element of a container lies
+    struct item {
+      // Key of a member, decoded and as written
+      text_token key;
+      std::string_view raw;
+
+      const char* begin;
+      const char* end;
+    };
+
+    // Moves past the next member or element of a container, from just past
+    // its opening bracket or the previous item. Returns an error message,
+    // or nullptr with `done` set at the end of the container. Commas are
+    // tolerated as by the reader.
+    const char* step(const char*& p, const char* end, bool object, bool& ready,
+                     std::pmr::string& scratch, item& result, bool& done) {
+      done = false;
+
+      while(true) {
+        p = skip_whitespace(p, end);
+        const char c = p < end ? *p : '\0';
+
+        if(c == ',') {
+          ready = true;
+          p++;
+          continue;
+        }
+
+        if(c == (object ? '}' : ']')) {
+          p++;
+          done = true;
+          return nullptr;
+        }
+
+        if(ready && p < end && (!object || c == '"')) break;
+
+        if(object) {
+          return p < end ? "parsing: invalid object" : "parsing: unterminated object";
+        }
+
+        return p < end ? "parsing: invalid array" : "parsing: unterminated array";
+      }
+
+      if(object) {
+        string_iterator text{std::string_view(p, end - p)};
+        if(const char* msg = read_text(text, scratch, result.key)) return msg;
+
+        result.raw = std::string_view(p + 1, text.position() - 2);
+        p = skip_whitespace(p + text.position(), end);
+
+        if(p == end || *p != ':') return "parsing: object key does not have value";
+        p = skip_whitespace(p + 1, end);
+      }
+
+      result.begin = p;
+      result.end = p = skip(p, end);
+      ready = false;
+      return nullptr;
+    }
+  }
+
+  lazy_value lazy_value::fail(const char* msg) {
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    lazy_value result;
+    result.message = msg;
+    return result;
+    #endif
+  }
+
+  // Scalars are read, and so validated, as soon as they are located
+  lazy_value lazy_value::locate(const char* begin, const char* end) {
+    lazy_value result;
+    result.begin = begin;
+    result.end = end;
+
+    string_iterator text{std::string_view(begin, end - begin)};
+
+    switch(text.peek()) {
+      case '{':
+        result.type = json::value_type::object;
+        break;
+      case '[':
+        result.type = json::value_type::array;
+        break;
+      case '"':
+        result.type = json::value_type::string;
+        break;
+      case '-':
+      case '0': case '1':
+      case '2': case '3':
+      case '4': case '5':
+      case '6': case '7':
+      case '8': case '9': {
+        bool floating;
+        if(const char* msg = read_number(text, floating)) return fail(msg);
+
+        result.type = floating ? json::value_type::floating : json::value_type::integer;
+        result.end = begin + text.position();
+      } break;
+      default:
+        if(const char* msg = read_literal(text, result.type)) return fail(msg);
+        result.end = begin + text.position();
+        break;
+    }
+
+    return result;
+  }
+
+  bool lazy_value::next(const char*& position, const char* end, bool object,
+                        bool& ready, json::lazy_member& item) {
+    std::pmr::string scratch;
+    json::item found;
+    bool done;
+
+    if(const char* msg = step(position, end, object, ready, scratch, found, done)) {
+      item = {{}, fail(msg)};
+      return true;
+    }
+
+    if(done) return false;
+
+    item = {found.raw, locate(found.begin, found.end)};
+    return true;
+  }
+
+  lazy_value parse_lazy(std::string_view text) {
+    const char* end = text.data() + text.size();
+    return lazy_value::locate(skip_whitespace(text.data(), end), end);
+  }
+
+  bool lazy_value::is_object() const {
+    return type == json::value_type::object;
+  }
+
+  bool lazy_value::is_array() const {
+    return type == json::value_type::array;
+  }
+
+  bool lazy_value::is_bool() const {
+    return type == json::value_type::true_literal ||
+      type == json::value_type::false_literal;
+  }
+
+  bool lazy_value::is_string() const {
+    return type == json::value_type::string;
+  }
+
+  bool lazy_value::is_number() const {
+    return type == json::value_type::integer ||
+      type == json::value_type::floating;
+  }
+
+  bool lazy_value::is_integer() const {
+    return type == json::value_type::integer;
+  }
+
+  bool lazy_value::is_float() const {
+    return type == json::value_type::floating;
+  }
+
+  bool lazy_value::is_null() const {
+    return type == json::value_type::null_literal;
+  }
+
+  size_t lazy_value::size() const {
+    if(is_string()) return ((std::string)*this).size();
+    if(!is_object() && !is_array()) return 0;
+
+    std::pmr::string scratch;
+    json::item found;
+    bool ready = true, done;
+    size_t count = 0;
+
+    for(const char* p = begin + 1;; count++) {
+      if(const char* msg = step(p, end, is_object(), ready, scratch, found, done)) {
+        fail(msg);
+        return 0;
+      }
+
+      if(done) return count;
+
+      // Scalars at this level are validated like the rest of it
+      if(locate(found.begin, found.end).message) return 0;
+    }
+  }
+
+  // A key repeated within an object resolves to its last occurrence, as
+  // parse keeps it, so the whole object is scanned
+  std::optional<lazy_value> lazy_value::find(std::string_view key) const {
+    if(!is_object()) return std::nullopt;
+
+    std::pmr::string scratch;
+    json::item member;
+    bool ready = true, done;
+    const char* found = nullptr;
+    const char* found_end = nullptr;
+
+    for(const char* p = begin + 1;;) {
+      if(const char* msg = step(p, end, true, ready, scratch, member, done)) {
+        return fail(msg);
+      }
+
+      if(done) break;
+      if(member.key.text == key) {
+        found = member.begin;
+        found_end = member.end;
+      }
+    }
+
+    if(!found) return std::nullopt;
+    return locate(found, found_end);
+  }
+
+  lazy_value lazy_value::operator[](std::string_view key) const {
+    return find(key).value_or(lazy_value());
+  }
+
+  lazy_value lazy_value::operator[](size_t i) const {
+    return at(i);
+  }
+
+  lazy_value lazy_value::at(std::string_view key) const {
+    if(std::optional<lazy_value> member = find(key)) return *member;
+    return fail("object key not found");
+  }
+
+  lazy_value lazy_value::at(size_t i) const {
+    if(is_array()) {
+      std::pmr::string scratch;
+      json::item element;
+      bool ready = true, done;
+      size_t index = 0;
+
+      for(const char* p = begin + 1;; index++) {
+        if(const char* msg = step(p, end, false, ready, scratch, element, done)) {
+          return fail(msg);
+        }
+
+        if(done) break;
+        if(index == i) return locate(element.begin, element.end);
+      }
+    }
+
+    return fail("array index out of bounds");
+  }
+
+  lazy_range<lazy_member> lazy_value::members() const {
+    if(!is_object()) return {};
+    return {begin + 1, end, true};
+  }
+
+  lazy_range<lazy_value> lazy_value::elements() const {
+    if(!is_array()) return {};
+    return {begin + 1, end, false};
+  }
+
+  bool lazy_value::is_unsigned() const {
+    return is_integer() && materialize().is_unsigned();
+  }
+
+  std::int64_t lazy_value::as_int64() const {
+    return is_number() ? materialize().as_int64() : 0;
+  }
+
+  std::uint64_t lazy_value::as_uint64() const {
+    return is_number() ? materialize().as_uint64() : 0;
+  }
+
+  double lazy_value::as_double() const {
+    return is_number() ? materialize().as_double() : 0;
+  }
+
+  std::string_view lazy_value::raw_string_view() const {
+    if(!is_string()) return {};
+
+    const char* last = skip(begin, end);
+    if(last - begin < 2 || last[-1] != '"') {
+      fail("parsing: unterminated string");
+      return {};
+    }
+
+    return std::string_view(begin + 1, last - begin - 2);
+  }
+
+  std::string_view lazy_value::raw_json() const {
+    switch(type) {
+      case json::value_type::undefined:
+        return {};
+      case json::value_type::object:
+      case json::value_type::array:
+      case json::value_type::string:
+        return std::string_view(begin, skip(begin, end) - begin);
+      default:
+        return std::string_view(begin, end - begin);
+    }
+  }
+
+  json::value lazy_value::materialize() const {
+    switch(type) {
+      case json::value_type::undefined:
+        #ifdef NO_EXCEPTIONS
+        if(message) return json::error(message);
+        #endif
+        return json::value();
+      case json::value_type::object:
+      case json::value_type::array:
+        return json::parse(raw_json());
+      case json::value_type::string:
+        return json::value((std::string)*this);
+      case json::value_type::integer:
+      case json::value_type::floating:
+        return convert_number(raw_json(), is_float());
+      default:
+        return json::value(type);
+    }
+  }
+
+  lazy_value::operator std::string() const {
+    if(!is_string()) return (std::string)materialize();
+
+    std::pmr::string scratch;
+    string_iterator text{std::string_view(begin, end - begin)};
+    text_token token;
+
+    if(const char* msg = read_text(text, scratch, token)) {
+      fail(msg);
+      return {};
+    }
+
+    return std::string(token.text);
+  }
+
+  lazy_value::operator int() const {
+    return is_number() || is_bool() ? (int)materialize() : 0;
+  }
+
+  lazy_value::operator bool() const {
+    return !(type == json::value_type::false_literal ||
+             type == json::value_type::undefined);
+  }
+
+  lazy_value::operator double() const {
+    return is_number() ? as_double() : 0;
+  }
+
+  #ifdef NO_EXCEPTIONS
+  bool lazy_value::error() const {
+    return type == json::value_type::undefined;
+  }
+  #endif
+}
@@ -0,0 +1,151 @@
+#include "json.h"
+#include "file.h"
+#include "pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+namespace json {
+  namespace {
+    // Splits text into chunks of whole lines, sized so that every worker
+    // gets several of them to balance uneven records
+    std::vector<std::string_view> split(std::string_view text, unsigned threads) {
+      const size_t target = std::clamp<size_t>(text.size() / (threads * 4),
+                                               64 * 1024, 1024 * 1024);
+      std::vector<std::string_view> chunks;
+
+      while(!text.empty()) {
+        size_t end = std::min(target, text.size());
+        const char* newline = (const char*)std::memchr(text.data() + end - 1, '\n',
+                                                       text.size() - end + 1);
+        end = newline ? newline - text.data() + 1 : text.size();
+
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+      }
+
+      return chunks;
+    }
+
+    // Calls `record` with every line of a chunk that is not blank
+    template<typename Record>
+    void for_each_line(std::string_view chunk, Record record) {
+      while(!chunk.empty()) {
+        const size_t end = std::min(chunk.find('\n'), chunk.size());
+        std::string_view line = chunk.substr(0, end);
+        chunk.remove_prefix(std::min(end + 1, chunk.size()));
+
+        if(line.find_first_not_of(" \t\r") != std::string_view::npos) record(line);
+      }
+    }
+
+    #ifndef NO_EXCEPTIONS
+    // Rethrows a parse error with the number of the line it occurred on
+    [[noreturn]] void rethrow(std::string_view text, std::string_view line,
+                              const json::exception& e) {
+      const size_t number = std::count(text.data(), line.data(), '\n') + 1;
+      throw json::exception(std::format("line {}: {}", number, e.what()));
+    }
+    #endif
+
+    struct stateless {};
+  }
+
+  std::vector<json::value> parse_lines(std::string_view text,
+                                       const json::lines_options& options) {
+    json::parse_options parse = options.parse;
+    parse.symbols = nullptr;
+
+    const unsigned threads = thread_count(options.threads);
+    const std::vector<std::string_view> chunks = split(text, threads);
+    std::vector<std::vector<json::value>> parts(chunks.size());
+
+    run<stateless>(chunks.size(), threads, [&](size_t i, stateless&) {
+      for_each_line(chunks[i], [&](std::string_view line) {
+        #ifndef NO_EXCEPTIONS
+        try {
+          parts[i].push_back(json::parse(line, parse));
+        } catch(const json::exception& e) {
+          rethrow(text, line, e);
+        }
+        #else
+        parts[i].push_back(json::parse(line, parse));
+        #endif
+      });
+    });
+
+    size_t count = 0;
+    for(const auto& part : parts) count += part.size();
+
+    std::vector<json::value> records;
+    records.reserve(count);
+    for(auto& part : parts) {
+      std::move(part.begin(), part.end(), std::back_inserter(records));
+    }
+
+    return records;
+  }
+
+  void parse_lines(std::string_view text,
+                   const std::function<void(const json::value&)>& callback,
+                   const json::lines_options& options) {
+    json::parse_options parse = options.parse;
+    parse.symbols = nullptr;
+
+    const unsigned threads = thread_count(options.threads);
+    const std::vector<std::string_view> chunks = split(text, threads);
+
+    run<json::document>(chunks.size(), threads, [&](size_t i, json::document& document) {
+      for_each_line(chunks[i], [&](std::string_view line) {
+        #ifndef NO_EXCEPTIONS
+        try {
+          document.parse(line, parse);
+        } catch(const json::exception& e) {
+          rethrow(text, line, e);
+        }
+        #else
+        document.parse(line, parse);
+        #endif
+
+        callback(document.root());
+      });
+    });
+  }
+
+  std::vector<json::value> load_ndjson(const std::filesystem::path& filename,
+                                       const json::lines_options& options) {
+    mapped_file file;
+
+    if(const char* msg = file.open(filename)) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      return { json::error(msg) };
+      #endif
+    }
+
+    // The records outlive the mapping
+    json::lines_options copied = options;
+    copied.parse.in_situ = false;
+
+    return parse_lines(file.text(), copied);
+  }
+
+  void load_ndjson(const std::filesystem::path& filename,
+                   const std::function<void(const json::value&)>& callback,
+                   const json::lines_options& options) {
+    mapped_file file;
+
+    if(const char* msg = file.open(filename)) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      callback(json::error(msg));
+      return;
+      #endif
+    }
+
+    parse_lines(file.text(), callback, options);
+  }
+}
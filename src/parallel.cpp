@@ -0,0 +1,134 @@
+#include "json.h"
+#include "pool.h"
+#include "reader.h"
+
+namespace json {
+  namespace {
+    // Documents below this size are parsed on one thread
+    constexpr size_t parallel_threshold = 1024 * 1024;
+
+    // Structural index of a worker, reused across its ranges
+    struct worker {
+      std::vector<std::uint32_t> structurals;
+    };
+
+    // Members or elements of one range: values, or keys and values in turn
+    struct part {
+      std::vector<json::value> values;
+      const char* message = nullptr;
+    };
+
+    // Reads the members or elements of a container that lie between two of
+    // its commas, or a comma and a bracket. Returns an error message, or
+    // nullptr. Commas are tolerated as by the reader.
+    const char* read_range(std::string_view range, bool object, builder& build,
+                           std::vector<std::uint32_t>& structurals,
+                           std::vector<json::value>& values) {
+      string_iterator text{range, structurals};
+      tree_handler handler{build};
+      reader<tree_handler> read{text, handler, build.resource()};
+      std::pmr::string scratch{build.resource()};
+
+      for(bool ready = true;; ready = false) {
+        text.skip_whitespace();
+        while(text.peek() == ',') {
+          ready = true;
+          text.next();
+          text.skip_whitespace();
+        }
+
+        if(!text.available()) return nullptr;
+        if(!ready) return object ? "parsing: invalid object" : "parsing: invalid array";
+
+        if(object) {
+          if(text.peek() != '"') return "parsing: invalid object";
+
+          text_token key;
+          if(const char* msg = read_text(text, scratch, key)) return msg;
+          values.push_back(build.key(key.text, key.input));
+
+          text.skip_whitespace();
+          if(text.peek() != ':') return "parsing: object key does not have value";
+          text.next();
+        }
+
+        if(!read.value()) return read.error();
+        values.push_back(std::move(handler.result()));
+      }
+    }
+  }
+
+  json::value parse_parallel(std::string_view text,
+                             const json::parallel_options& options) {
+    json::parse_options parse = options.parse;
+    parse.symbols = nullptr;
+
+    const unsigned threads = thread_count(options.threads);
+    const char* end = text.data() + text.size();
+    const char* begin = text.data();
+    while(begin < end && is_whitespace(*begin)) begin++;
+
+    if(threads < 2 || text.size() < parallel_threshold ||
+       begin == end || (*begin != '[' && *begin != '{')) {
+      return json::parse(text, parse);
+    }
+
+    const bool object = *begin == '{';
+    const size_t grain = std::clamp<size_t>(text.size() / (threads * 4),
+                                            256 * 1024, 64 * 1024 * 1024);
+
+    std::vector<const char*> commas;
+    const char* close = simd::split_container(begin, end, grain, commas);
+
+    // Malformed at the top level; let the reader describe it
+    if(!close || close[-1] != (object ? '}' : ']')) return json::parse(text, parse);
+
+    std::vector<std::string_view> ranges;
+    const char* start = begin + 1;
+    for(const char* comma : commas) {
+      ranges.emplace_back(start, comma - start);
+      start = comma + 1;
+    }
+    ranges.emplace_back(start, close - 1 - start);
+
+    std::vector<part> parts(ranges.size());
+    run<worker>(ranges.size(), threads, [&](size_t i, worker& state) {
+      builder build{nullptr, parse};
+      parts[i].message = read_range(ranges[i], object, build, state.structurals,
+                                    parts[i].values);
+
+      #ifndef NO_EXCEPTIONS
+      if(parts[i].message) throw json::exception(parts[i].message);
+      #endif
+    });
+
+    builder build{nullptr, parse};
+    json::value result = object ? build.object() : build.array();
+
+    size_t count = 0;
+    for(const part& range : parts) {
+      #ifdef NO_EXCEPTIONS
+      if(range.message) return json::error(range.message);
+      #endif
+      count += range.values.size();
+    }
+
+    if(!object) build.reserve(result, count);
+
+    for(part& range : parts) {
+      std::vector<json::value>& values = range.values;
+
+      if(object) {
+        for(size_t i = 0; i < values.size(); i += 2) {
+          build.insert(result, std::move(values[i]), std::move(values[i + 1]));
+        }
+      } else {
+        for(json::value& element : values) build.append(result, std::move(element));
+      }
+
+      values = {};
+    }
+
+    return result;
+  }
+}
@@ -0,0 +1,346 @@
+#include "json.h"
+#include "reader.h"
+
+#include <charconv>
+
+namespace json {
+  namespace {
+    // Whether one of the paths of `mask` ends at a value of `depth`
+    bool ends(const std::vector<json::path>& paths, std::uint64_t mask,
+              size_t depth) {
+      for(; mask; mask &= mask - 1) {
+        if(paths[__builtin_ctzll(mask)].size() == depth) return true;
+      }
+
+      return false;
+    }
+
+    // Array index named by a token: "0" or digits without a leading zero
+    size_t array_index(std::string_view name) {
+      if(name.empty() || (name[0] == '0' && name.size() > 1)) return -1;
+
+      size_t index;
+      const char* end = name.data() + name.size();
+      const auto result = std::from_chars(name.data(), end, index);
+
+      return result.ec == std::errc() && result.ptr == end ? index : -1;
+    }
+
+    // Passes each token of a pointer, unescaped, to `visit` along with the
+    // array index it names (or -1), until `visit` returns false. Tokens
+    // with escapes are unescaped into `scratch`. Returns an error message
+    // if the pointer is malformed, or nullptr.
+    template<typename Visit>
+    const char* tokenize(std::string_view pointer, std::string& scratch, Visit visit) {
+      if(!pointer.empty() && pointer[0] != '/') {
+        return "pointer: must be empty or start with '/'";
+      }
+
+      for(size_t begin = 1; begin <= pointer.size();) {
+        size_t end = pointer.find('/', begin);
+        if(end == std::string_view::npos) end = pointer.size();
+
+        std::string_view name = pointer.substr(begin, end - begin);
+
+        if(name.find('~') != std::string_view::npos) {
+          scratch.clear();
+
+          for(size_t i = 0; i < name.size(); ++i) {
+            if(name[i] != '~') {
+              scratch += name[i];
+            } else if(i + 1 < name.size() && (name[i + 1] == '0' || name[i + 1] == '1')) {
+              scratch += name[++i] == '0' ? '~' : '/';
+            } else {
+              return "pointer: '~' must be followed by '0' or '1'";
+            }
+          }
+
+          name = scratch;
+        }
+
+        if(!visit(name, array_index(name))) break;
+        begin = end + 1;
+      }
+
+      return nullptr;
+    }
+  }
+
+  path::path(std::string_view pointer) {
+    std::string scratch;
+    message = tokenize(pointer, scratch, [this](std::string_view name, size_t index) {
+      tokens.push_back({(std::uint32_t)names.size(), (std::uint32_t)name.size(), index});
+      names += name;
+      return true;
+    });
+
+    if(message) {
+      tokens.clear();
+
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(message);
+      #endif
+    }
+  }
+
+  const value* path::find(const json::value& root, size_t from) const {
+    if(message) return nullptr;
+
+    const json::value* current = &root;
+    for(size_t i = from; current && i < tokens.size(); ++i) {
+      if(current->is_object()) {
+        current = current->find(name(i));
+      } else if(current->is_array() && tokens[i].index < current->size()) {
+        current = &current->elements()[tokens[i].index];
+      } else {
+        current = nullptr;
+      }
+    }
+
+    return current;
+  }
+
+  const value* value::find(const json::path& path) const {
+    return path.find(*this);
+  }
+
+  // Walks the pointer as it is read, so that nothing is allocated
+  const value& value::at_pointer(std::string_view pointer) const {
+    std::string scratch;
+    const json::value* current = this;
+
+    const char* msg = tokenize(pointer, scratch, [&current](std::string_view name, size_t index) {
+      if(current->is_object()) {
+        current = current->find(name);
+      } else if(current->is_array() && index < current->size()) {
+        current = &current->elements()[index];
+      } else {
+        current = nullptr;
+      }
+
+      return current != nullptr;
+    });
+
+    if(!msg && current) return *current;
+    if(!msg) msg = "pointer: no value at path";
+
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    static thread_local json::value invalid;
+    invalid = json::error(msg);
+    return invalid;
+    #endif
+  }
+
+  const value& value::at_pointer(const json::path& path) const {
+    if(const json::value* found = path.find(*this)) return *found;
+
+    const char* msg = "pointer: no value at path";
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    static const json::value none = json::error(msg);
+    return none;
+    #endif
+  }
+
+  lazy_value lazy_value::at_pointer(std::string_view pointer) const {
+    return at_pointer(json::path(pointer));
+  }
+
+  lazy_value lazy_value::at_pointer(const json::path& path) const {
+    if(path.message) return fail(path.message);
+
+    lazy_value current = *this;
+    for(size_t i = 0; i < path.size(); ++i) {
+      std::optional<lazy_value> next;
+
+      if(current.is_object()) {
+        next = current.find(path.name(i));
+      } else if(current.is_array() && path.tokens[i].index != path::npos) {
+        size_t index = 0;
+        for(const lazy_value& element : current.elements()) {
+          if(index++ == path.tokens[i].index || element.message) {
+            next = element;
+            break;
+          }
+        }
+      }
+
+      if(!next) return fail("pointer: no value at path");
+      if(next->message) return *next;
+      current = *next;
+    }
+
+    return current;
+  }
+
+  selector::selector(std::vector<json::path> paths,
+                     std::function<void(size_t, const json::value&)> found) :
+    paths(std::move(paths)), found(std::move(found)) {
+    if(this->paths.size() > 64) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception("selecting: at most 64 paths are supported");
+      #else
+      this->paths.resize(64);
+      #endif
+    }
+
+    for(size_t i = 0; i < this->paths.size(); ++i) {
+      if(!this->paths[i].message) remaining |= 1ULL << i;
+    }
+
+    stack.reserve(32);
+  }
+
+  // Paths that match the value starting now, outside of a capture
+  std::uint64_t selector::enter() {
+    if(stack.empty()) return remaining;
+
+    frame& top = stack.back();
+    if(!top.array) return pending;
+
+    const size_t depth = stack.size() - 1;
+    std::uint64_t result = 0;
+
+    for(std::uint64_t bits = top.mask; bits; bits &= bits - 1) {
+      const int i = __builtin_ctzll(bits);
+      if(paths[i].size() > depth && paths[i].selects(depth, top.index)) {
+        result |= 1ULL << i;
+      }
+    }
+
+    top.index++;
+    return result;
+  }
+
+  // Reports the paths of `mask` that end at or below a value at `depth`.
+  // Returns false to stop once every path has been found.
+  bool selector::deliver(std::uint64_t mask, size_t depth, const json::value& value) {
+    for(std::uint64_t bits = mask & remaining; bits; bits &= bits - 1) {
+      const int i = __builtin_ctzll(bits);
+
+      if(const json::value* match = paths[i].find(value, depth)) {
+        remaining &= ~(1ULL << i);
+        found(i, *match);
+      }
+    }
+
+    return remaining != 0;
+  }
+
+  // Containers are only built inside a selected value
+  bool selector::begin(json::value_type type) {
+    if(capture.empty()) {
+      const std::uint64_t mask = enter();
+
+      if(!ends(paths, mask, stack.size())) {
+        stack.push_back({mask, 0, type == json::value_type::array});
+        return true;
+      }
+
+      captured = mask;
+      capture_depth = stack.size();
+    }
+
+    capture.push_back({json::value(type), json::value()});
+    return true;
+  }
+
+  bool selector::end() {
+    if(capture.empty()) {
+      stack.pop_back();
+      return true;
+    }
+
+    json::value complete = std::move(capture.back().first);
+    capture.pop_back();
+
+    if(capture.empty()) return deliver(captured, capture_depth, complete);
+    return add(0, std::move(complete));
+  }
+
+  bool selector::wanted(std::uint64_t& mask) {
+    if(!capture.empty()) return true;
+
+    mask = enter();
+    return ends(paths, mask, stack.size());
+  }
+
+  bool selector::add(std::uint64_t mask, json::value&& element) {
+    if(capture.empty()) return deliver(mask, stack.size(), element);
+
+    builder build;
+    auto& [container, key] = capture.back();
+
+    if(container.is_array()) {
+      build.append(container, std::move(element));
+    } else {
+      build.insert(container, std::move(key), std::move(element));
+    }
+
+    return true;
+  }
+
+  bool selector::on_object_begin() {
+    return begin(json::value_type::object);
+  }
+
+  bool selector::on_array_begin() {
+    return begin(json::value_type::array);
+  }
+
+  bool selector::on_object_end() { return end(); }
+  bool selector::on_array_end() { return end(); }
+
+  bool selector::on_key(std::string_view key) {
+    if(!capture.empty()) {
+      capture.back().second = json::value(std::string(key));
+      return true;
+    }
+
+    const size_t depth = stack.size() - 1;
+    pending = 0;
+
+    for(std::uint64_t bits = stack.back().mask; bits; bits &= bits - 1) {
+      const int i = __builtin_ctzll(bits);
+      if(paths[i].size() > depth && paths[i].name(depth) == key) {
+        pending |= 1ULL << i;
+      }
+    }
+
+    return true;
+  }
+
+  // Scalars are only built when they are selected
+  bool selector::on_string(std::string_view str) {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(std::string(str)));
+  }
+
+  bool selector::on_int64(std::int64_t number) {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(number));
+  }
+
+  bool selector::on_uint64(std::uint64_t number) {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(number));
+  }
+
+  bool selector::on_double(double number) {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(number));
+  }
+
+  bool selector::on_bool(bool boolean) {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(boolean));
+  }
+
+  bool selector::on_null() {
+    std::uint64_t mask = 0;
+    return !wanted(mask) || add(mask, json::value(json::value_type::null_literal));
+  }
+}
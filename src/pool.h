@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace json {
+  // Threads to use when `requested` is 0: one per core
+  inline unsigned thread_count(unsigned requested) {
+    if(requested) return requested;
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Runs work(chunk, state) for every chunk on a pool of threads, the
+  // calling thread included. Each thread has its own State. The first
+  // exception stops the remaining chunks and is rethrown.
+  template<typename State, typename Work>
+  void run(size_t chunks, unsigned threads, Work work) {
+    std::atomic<size_t> next{0};
+
+    #ifndef NO_EXCEPTIONS
+    std::exception_ptr failure;
+    std::mutex lock;
+    #endif
+
+    const auto worker = [&] {
+      State state;
+
+      for(size_t i; (i = next++) < chunks;) {
+        #ifndef NO_EXCEPTIONS
+        try {
+          work(i, state);
+        } catch(...) {
+          std::lock_guard<std::mutex> guard(lock);
+          if(!failure) failure = std::current_exception();
+          next = chunks;
+        }
+        #else
+        work(i, state);
+        #endif
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < std::min<size_t>(threads, chunks); ++i) {
+      pool.emplace_back(worker);
+    }
+
+    worker();
+    for(std::thread& thread : pool) thread.join();
+
+    #ifndef NO_EXCEPTIONS
+    if(failure) std::rethrow_exception(failure);
+    #endif
+  }
+}
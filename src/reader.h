@@ -0,0 +1,814 @@
+#pragma once
+
+#include "json.h"
+#include "simd.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The grammar of the parser, shared by every front end. A json::reader
+// walks the input and reports what it finds to a handler; the tree builder
+// behind json::parse and the json::handler adapter behind json::parse_events
+// are both handlers. A handler provides:
+//
+//   bool object_begin();  bool object_end();
+//   bool array_begin();   bool array_end();
+//   bool key(const text_token&);  bool string(const text_token&);
+//   bool number(std::string_view lexeme, bool floating);
+//   bool literal(json::value_type type);
+//
+// Returning false from any of them stops the reader.
+namespace json {
+  // Cursor over the input. When a structural index is available (see
+  // simd::index), whitespace and string contents are skipped by jumping to
+  // the next indexed position instead of visiting every byte.
+  class string_iterator {
+    private:
+      std::string_view text;
+      size_t index;
+
+      const std::uint32_t* structural;
+      const std::uint32_t* structural_end;
+    public:
+      string_iterator(const std::string_view& text);
+      string_iterator(const std::string_view& text,
+                      std::vector<std::uint32_t>& structurals);
+
+      bool available() const { return index < text.size(); }
+      char peek() const { return available() ? text[index] : '\0'; }
+      char next() { return available() ? text[index++] : '\0'; }
+
+      size_t position() const { return index; }
+      // Moves back to an earlier position, to report an error found in
+      // text already consumed
+      void rewind(size_t position) { index = position; }
+      std::string_view slice(size_t begin) const {
+        return text.substr(begin, index - begin);
+      }
+
+      void skip_whitespace();
+      // Advances to the next '"' or '\\' inside a string
+      void skip_to_quote();
+      // Advances to the next '"', '\\' or control character inside a string
+      void skip_to_escape();
+  };
+
+  // Inputs below this size are not worth indexing up front
+  constexpr size_t index_threshold = 4096;
+
+  inline bool is_whitespace(const char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  inline bool is_digit(const char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  // A decoded string literal: a view of the input when the literal has no
+  // escapes, or of the decoding buffer otherwise
+  struct text_token {
+    std::string_view text;
+    bool input = false;
+  };
+
+  // Reads a string literal starting at its opening quote. Returns an error
+  // message if it is malformed or not UTF-8, or nullptr.
+  const char* read_text(string_iterator& text, std::pmr::string& str,
+                        text_token& token);
+
+  // Checks a string literal starting at its opening quote without decoding
+  // it, also rejecting the unescaped control characters that RFC 8259
+  // forbids. Returns an error message if it is malformed, or nullptr.
+  const char* read_text(string_iterator& text);
+
+  // Literals and numbers must be followed by whitespace, a structural
+  // character or the end of the input
+  inline bool is_delimiter(const char c) {
+    switch(c) {
+      case '\0': case ',':
+      case ']': case '}':
+      case ':':
+        return true;
+      default:
+        return is_whitespace(c);
+    }
+  }
+
+  // Reads a number starting at its first character; its lexeme is the text
+  // consumed. Returns an error message if it is malformed, or nullptr.
+  inline const char* read_number(string_iterator& text, bool& floating) {
+    // Advances over a run of digits, returning false if there is none
+    const auto digits = [&text] {
+      if(!is_digit(text.peek())) return false;
+
+      do {
+        text.next();
+      } while(is_digit(text.peek()));
+
+      return true;
+    };
+
+    floating = false;
+
+    if(text.peek() == '-') {
+      // Optional minus sign for numbers
+      text.next();
+    }
+
+    if(text.peek() == '0') {
+      text.next();
+    } else if(!digits()) {
+      return "parsing: invalid number";
+    }
+
+    if(text.peek() == '.') {
+      text.next();
+      floating = true;
+      if(!digits()) return "parsing: decimal must be followed by digits";
+    }
+
+    if(text.peek() == 'e' || text.peek() == 'E') {
+      text.next();
+      floating = true;
+      if(text.peek() == '+' || text.peek() == '-') text.next();
+      if(!digits()) return "parsing: exponent must be followed by digits";
+    }
+
+    if(!is_delimiter(text.peek())) return "parsing: invalid number";
+    return nullptr;
+  }
+
+  // Reads true, false or null. Returns an error message if the text is
+  // none of them, or nullptr.
+  inline const char* read_literal(string_iterator& text, json::value_type& type) {
+    std::string_view literal;
+
+    switch(text.peek()) {
+      case 't':
+        type = json::value_type::true_literal;
+        literal = "true";
+        break;
+      case 'f':
+        type = json::value_type::false_literal;
+        literal = "false";
+        break;
+      case 'n':
+        type = json::value_type::null_literal;
+        literal = "null";
+        break;
+    }
+
+    for(size_t i = 0; i < literal.size() && text.peek() == literal[i]; ++i) {
+      text.next();
+      if(i + 1 == literal.size() && is_delimiter(text.peek())) return nullptr;
+    }
+
+    return "parsing: unrecognized literal";
+  }
+
+  // Creates the nodes of a parse tree, either owned by their parents on the
+  // heap or borrowed from a document arena. Text that points into the input
+  // is referenced rather than copied for in-situ parses.
+  class builder {
+    std::pmr::memory_resource* arena;
+    json::parse_options options;
+
+    public:
+      explicit builder(std::pmr::memory_resource* arena = nullptr,
+                       const json::parse_options& options = {});
+
+      std::pmr::memory_resource* resource() const;
+
+      json::value string(std::string_view str, bool input = false);
+      json::value key(std::string_view str, bool input);
+      json::value number(std::string_view str, bool floating);
+      json::value array();
+      json::value object();
+
+      void append(json::value& array, json::value&& element);
+      // Makes room for `size` elements or members
+      void reserve(json::value& container, size_t size);
+      void insert(json::value& object, json::value&& key,
+                  json::value&& element);
+  };
+
+  // Converts a well-formed number lexeme to binary. Integers that overflow
+  // 64 bits and floats outside the range of double are approximated.
+  json::value convert_number(std::string_view str, bool floating);
+
+  // Builds a parse tree from the reader's events. Containers that are still
+  // open are kept on a stack, each with the key its next member will take.
+  class tree_handler {
+    struct frame {
+      json::value container;
+      json::value key;
+    };
+
+    builder& build;
+    std::pmr::vector<frame> stack;
+    json::value tree;
+
+    bool add(json::value&& element) {
+      if(stack.empty()) {
+        tree = std::move(element);
+      } else if(frame& top = stack.back(); top.container.is_array()) {
+        build.append(top.container, std::move(element));
+      } else {
+        build.insert(top.container, std::move(top.key), std::move(element));
+      }
+
+      return true;
+    }
+
+    bool close() {
+      json::value container = std::move(stack.back().container);
+      stack.pop_back();
+      return add(std::move(container));
+    }
+
+    public:
+      explicit tree_handler(builder& build) :
+        build(build), stack(build.resource()) {
+        stack.reserve(32);
+      }
+
+      json::value& result() { return tree; }
+
+      bool object_begin() {
+        stack.push_back({build.object(), json::value()});
+        return true;
+      }
+
+      bool array_begin() {
+        stack.push_back({build.array(), json::value()});
+        return true;
+      }
+
+      bool object_end() { return close(); }
+      bool array_end() { return close(); }
+
+      bool key(const text_token& token) {
+        stack.back().key = build.key(token.text, token.input);
+        return true;
+      }
+
+      bool string(const text_token& token) {
+        return add(build.string(token.text, token.input));
+      }
+
+      bool number(std::string_view lexeme, bool floating) {
+        return add(build.number(lexeme, floating));
+      }
+
+      // A number decoded from a binary encoding
+      bool number(json::value&& number) {
+        return add(std::move(number));
+      }
+
+      bool literal(json::value_type type) {
+        return add(json::value(type));
+      }
+
+      // Makes room for the members or elements of the innermost container
+      void reserve(size_t count) {
+        build.reserve(stack.back().container, count);
+      }
+  };
+
+  // Forwards the reader's events to a json::handler
+  class event_handler {
+    json::handler& events;
+
+    public:
+      explicit event_handler(json::handler& events) : events(events) {}
+
+      bool object_begin() { return events.on_object_begin(); }
+      bool object_end() { return events.on_object_end(); }
+      bool array_begin() { return events.on_array_begin(); }
+      bool array_end() { return events.on_array_end(); }
+
+      bool key(const text_token& token) { return events.on_key(token.text); }
+      bool string(const text_token& token) { return events.on_string(token.text); }
+
+      bool number(std::string_view lexeme, bool floating) {
+        return number(convert_number(lexeme, floating));
+      }
+
+      bool number(const json::value& number) {
+        if(number.is_float()) return events.on_double(number.as_double());
+        if(number.is_unsigned()) return events.on_uint64(number.as_uint64());
+        return events.on_int64(number.as_int64());
+      }
+
+      bool literal(json::value_type type) {
+        switch(type) {
+          case json::value_type::true_literal: return events.on_bool(true);
+          case json::value_type::false_literal: return events.on_bool(false);
+          default: return events.on_null();
+        }
+      }
+
+      void reserve(size_t) {}
+  };
+
+  // Builds nothing, and only stops the reader at containers nested deeper
+  // than its limit
+  class validator {
+    size_t depth = 0;
+    size_t limit;
+
+    public:
+      explicit validator(size_t limit) : limit(limit) {}
+
+      bool object_begin() { return ++depth <= limit; }
+      bool object_end() { depth--; return true; }
+      bool array_begin() { return ++depth <= limit; }
+      bool array_end() { depth--; return true; }
+
+      bool key(const text_token&) { return true; }
+      bool string(const text_token&) { return true; }
+      bool number(std::string_view, bool) { return true; }
+      bool literal(json::value_type) { return true; }
+  };
+
+  // A strict reader accepts exactly the grammar of RFC 8259: no stray
+  // commas and no unescaped control characters in strings. It only checks
+  // strings, so its handler is given empty text tokens.
+  template<typename Handler, bool strict = false>
+  class reader {
+    string_iterator& text;
+    Handler& handler;
+
+    // Decoding buffer for escaped strings, reused across the whole parse
+    std::pmr::string scratch;
+
+    const char* message = nullptr;
+    size_t offset = 0;
+
+    bool fail(const char* msg) {
+      message = msg;
+      offset = text.position();
+      return false;
+    }
+
+    bool object() {
+      text.next();
+      if(!handler.object_begin()) return false;
+
+      // Leading, trailing and repeated commas are tolerated unless strict
+      bool ready = true, comma = false;
+
+      while(true) {
+        text.skip_whitespace();
+
+        switch(text.peek()) {
+          case ',':
+            if(strict && ready) return fail("parsing: invalid object");
+            ready = comma = true;
+            text.next();
+            continue;
+          case '}':
+            if(strict && ready && comma) return fail("parsing: invalid object");
+            text.next();
+            return handler.object_end();
+          case '"':
+            if(ready) break;
+            [[fallthrough]];
+          default:
+            return fail(text.available() ?
+              "parsing: invalid object" : "parsing: unterminated object");
+        }
+
+        text_token key;
+        if(const char* msg = read_string(key)) return fail(msg);
+        if(!handler.key(key)) return false;
+
+        text.skip_whitespace();
+        if(text.peek() != ':') return fail("parsing: object key does not have value");
+        text.next();
+
+        if(!value()) return false;
+        ready = false;
+      }
+    }
+
+    bool array() {
+      text.next();
+      if(!handler.array_begin()) return false;
+
+      bool ready = true, comma = false;
+
+      while(true) {
+        text.skip_whitespace();
+
+        switch(text.peek()) {
+          case ',':
+            if(strict && ready) return fail("parsing: invalid array");
+            ready = comma = true;
+            text.next();
+            continue;
+          case ']':
+            if(strict && ready && comma) return fail("parsing: invalid array");
+            text.next();
+            return handler.array_end();
+          default:
+            if(!ready || !text.available()) {
+              return fail(text.available() ?
+                "parsing: invalid array" : "parsing: unterminated array");
+            }
+            break;
+        }
+
+        if(!value()) return false;
+        ready = false;
+      }
+    }
+
+    const char* read_string(text_token& token) {
+      if constexpr(strict) return read_text(text);
+      else return read_text(text, scratch, token);
+    }
+
+    bool string() {
+      text_token token;
+      if(const char* msg = read_string(token)) return fail(msg);
+      return handler.string(token);
+    }
+
+    bool number() {
+      const size_t begin = text.position();
+      bool floating;
+
+      if(const char* msg = read_number(text, floating)) return fail(msg);
+      return handler.number(text.slice(begin), floating);
+    }
+
+    bool literal() {
+      json::value_type type;
+
+      if(const char* msg = read_literal(text, type)) return fail(msg);
+      return handler.literal(type);
+    }
+
+    public:
+      reader(string_iterator& text, Handler& handler,
+             std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+        text(text), handler(handler), scratch(resource) {}
+
+      // Reads one value and reports it to the handler. Returns false if the
+      // input is malformed or the handler stopped the reader.
+      bool value() {
+        text.skip_whitespace();
+
+        switch(text.peek()) {
+          case '{':
+            return object();
+          case '[':
+            return array();
+          case '"':
+            return string();
+          case '-':
+          case '0': case '1':
+          case '2': case '3':
+          case '4': case '5':
+          case '6': case '7':
+          case '8': case '9':
+            return number();
+          default:
+            return literal();
+        }
+      }
+
+      // Message of the syntax error that stopped the reader, or nullptr if
+      // there was none
+      const char* error() const { return message; }
+
+      // Position of the input at which the error was found
+      size_t error_offset() const { return offset; }
+  };
+
+  // The same grammar as json::reader, driven by chunks of input instead of
+  // recursion so that it can stop at the end of any chunk and resume with
+  // the next one. Tokens that lie within a chunk are read in place; only a
+  // token cut by the end of a chunk is copied, up to where it ends in the
+  // following chunks, and then read from the copy.
+  template<typename Handler>
+  class stream_reader {
+    // What the next token may be
+    enum class state : std::uint8_t {
+      value,         // the top-level value
+      member,        // the value of an object member, after its ':'
+      array_ready,   // an array element, ',' or ']'
+      array_done,    // ',' or ']' after an array element
+      object_ready,  // a key, ',' or '}'
+      object_done,   // ',' or '}' after an object member
+      colon,         // the ':' after a key
+      end            // nothing: the top-level value is complete
+    };
+
+    enum class token : std::uint8_t { none, key, string, scalar };
+
+    Handler& handler;
+
+    // Open containers, as '{' or '['
+    std::pmr::string stack;
+    state current = state::value;
+
+    // Token cut by the end of the last chunk, and whether the copy ends in
+    // the middle of an escape sequence
+    std::pmr::string pending;
+    token partial = token::none;
+    bool escape = false;
+
+    // Decoding buffer for escaped strings, reused across the whole parse
+    std::pmr::string scratch;
+
+    // Bytes of input in the chunks before the current one
+    size_t consumed = 0;
+
+    const char* message = nullptr;
+    size_t offset = 0;
+    bool stopped = false;
+
+    bool fail(const char* msg, size_t position) {
+      message = msg;
+      offset = consumed + position;
+      return false;
+    }
+
+    bool stop() {
+      stopped = true;
+      return false;
+    }
+
+    // Moves past a completed value
+    void complete() {
+      if(stack.empty()) {
+        current = state::end;
+      } else {
+        current = stack.back() == '[' ? state::array_done : state::object_done;
+      }
+    }
+
+    bool open(char bracket) {
+      if(!(bracket == '{' ? handler.object_begin() : handler.array_begin())) {
+        return stop();
+      }
+
+      stack += bracket;
+      current = bracket == '{' ? state::object_ready : state::array_ready;
+      return true;
+    }
+
+    bool close() {
+      const char bracket = stack.back();
+      stack.pop_back();
+
+      if(!(bracket == '{' ? handler.object_end() : handler.array_end())) {
+        return stop();
+      }
+
+      complete();
+      return true;
+    }
+
+    // Reads a token starting at the current position. When more input may
+    // follow and the token runs into the end of the text, it is copied to
+    // `pending` instead.
+    bool read(string_iterator& text, token kind, bool last) {
+      const size_t begin = text.position();
+
+      if(kind != token::scalar) {
+        text_token str;
+        const char* msg = read_text(text, scratch, str);
+
+        if(msg && !text.available() && !last) {
+          return defer(text.slice(begin), kind);
+        }
+
+        if(msg) return fail(msg, text.position());
+        if(!(kind == token::key ? handler.key(str) : handler.string(str))) {
+          return stop();
+        }
+
+        if(kind == token::key) {
+          current = state::colon;
+        } else {
+          complete();
+        }
+
+        return true;
+      }
+
+      const bool number = text.peek() == '-' || is_digit(text.peek());
+      bool floating = false;
+      json::value_type type = json::value_type::undefined;
+
+      const char* msg = number ?
+        read_number(text, floating) : read_literal(text, type);
+
+      if(!text.available() && !last) return defer(text.slice(begin), kind);
+      if(msg) return fail(msg, text.position());
+
+      const bool proceed = number ?
+        handler.number(text.slice(begin), floating) : handler.literal(type);
+      if(!proceed) return stop();
+
+      complete();
+      return true;
+    }
+
+    bool defer(std::string_view text, token kind) {
+      pending.assign(text);
+      partial = kind;
+
+      if(kind != token::scalar) {
+        // Whether the copy ends on an odd run of backslashes, past the quote
+        size_t backslashes = 0;
+        while(backslashes + 1 < pending.size() &&
+              pending[pending.size() - 1 - backslashes] == '\\') {
+          backslashes++;
+        }
+
+        escape = backslashes % 2;
+      }
+
+      return true;
+    }
+
+    // Extends the pending token with the start of the chunk, returning the
+    // number of bytes it takes. `complete` is set if the token ends there.
+    size_t resume(std::string_view chunk, bool& done) {
+      size_t length = 0;
+      done = false;
+
+      if(partial == token::scalar) {
+        while(length < chunk.size() && !is_delimiter(chunk[length])) length++;
+        done = length < chunk.size();
+      } else {
+        const char* begin = chunk.data();
+        const char* end = begin + chunk.size();
+        const char* cursor = begin;
+
+        if(escape && cursor != end) {
+          cursor++;
+          escape = false;
+        }
+
+        while(cursor != end) {
+          cursor = simd::find_quote(cursor, end);
+          if(cursor == end) break;
+
+          if(*cursor == '"') {
+            cursor++;
+            done = true;
+            break;
+          }
+
+          if(cursor + 1 == end) {
+            escape = true;
+            cursor = end;
+            break;
+          }
+
+          cursor += 2;
+        }
+
+        length = cursor - begin;
+      }
+
+      pending.append(chunk.substr(0, length));
+      return length;
+    }
+
+    public:
+      explicit stream_reader(Handler& handler,
+                             std::pmr::memory_resource* resource =
+                               std::pmr::get_default_resource()) :
+        handler(handler), stack(resource), pending(resource), scratch(resource) {}
+
+      // Reads the next chunk of input, or signals the end of the input when
+      // `last` is set. Returns false if the input is malformed or the
+      // handler stopped the reader; later calls then do nothing.
+      bool feed(std::string_view chunk, bool last = false) {
+        if(message || stopped) return false;
+
+        size_t start = 0;
+        if(partial != token::none) {
+          bool done;
+          start = resume(chunk, done);
+
+          if(!done && !last) {
+            consumed += chunk.size();
+            return true;
+          }
+
+          const token kind = partial;
+          partial = token::none;
+
+          string_iterator text{pending};
+          if(!read(text, kind, true)) return false;
+        }
+
+        string_iterator text{chunk.substr(start)};
+        consumed += start;
+
+        while(current != state::end) {
+          text.skip_whitespace();
+          if(!text.available()) break;
+
+          const char c = text.peek();
+          bool ok = true;
+
+          switch(current) {
+            case state::array_ready:
+              if(c == ',') {
+                text.next();
+                break;
+              }
+
+              if(c == ']') {
+                text.next();
+                ok = close();
+                break;
+              }
+
+              [[fallthrough]];
+            case state::value:
+            case state::member:
+              if(c == '{' || c == '[') {
+                text.next();
+                ok = open(c);
+              } else {
+                ok = read(text, c == '"' ? token::string : token::scalar, last);
+              }
+              break;
+            case state::array_done:
+              if(c == ',') {
+                text.next();
+                current = state::array_ready;
+              } else if(c == ']') {
+                text.next();
+                ok = close();
+              } else {
+                ok = fail("parsing: invalid array", text.position());
+              }
+              break;
+            case state::object_ready:
+            case state::object_done:
+              if(c == ',') {
+                text.next();
+                current = state::object_ready;
+              } else if(c == '}') {
+                text.next();
+                ok = close();
+              } else if(c == '"' && current == state::object_ready) {
+                ok = read(text, token::key, last);
+              } else {
+                ok = fail("parsing: invalid object", text.position());
+              }
+              break;
+            case state::colon:
+              if(c == ':') {
+                text.next();
+                current = state::member;
+              } else {
+                ok = fail("parsing: object key does not have value", text.position());
+              }
+              break;
+            case state::end:
+              break;
+          }
+
+          if(!ok) return false;
+          if(partial != token::none) break;
+        }
+
+        consumed += chunk.size() - start;
+        if(!last || current == state::end) return true;
+
+        switch(current) {
+          case state::array_ready:
+          case state::array_done:
+            return fail("parsing: unterminated array", 0);
+          case state::object_ready:
+          case state::object_done:
+            return fail("parsing: unterminated object", 0);
+          case state::colon:
+            return fail("parsing: object key does not have value", 0);
+          default:
+            return fail("parsing: unrecognized literal", 0);
+        }
+      }
+
+      // Whether the top-level value is complete
+      bool done() const { return current == state::end; }
+
+      const char* error() const { return message; }
+      size_t error_offset() const { return offset; }
+  };
+}
@@ -0,0 +1,587 @@
+#include "simd.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace json::simd {
+  // Character classes of a 64-byte block, one bit per byte
+  struct block {
+    std::uint64_t quote;
+    std::uint64_t backslash;
+    std::uint64_t structural;
+    std::uint64_t whitespace;
+    // The subset of structural that are brackets
+    std::uint64_t bracket;
+  };
+
+  block classify_scalar(const char* data) {
+    block result{};
+
+    for(int i = 0; i < 64; ++i) {
+      const std::uint64_t bit = 1ULL << i;
+      switch(data[i]) {
+        case '"': result.quote |= bit; break;
+        case '\\': result.backslash |= bit; break;
+        case '{': case '}':
+        case '[': case ']':
+          result.structural |= bit;
+          result.bracket |= bit;
+          break;
+        case ':': case ',':
+          result.structural |= bit;
+          break;
+        case ' ': case '\t':
+        case '\n': case '\r':
+          result.whitespace |= bit;
+          break;
+      }
+    }
+
+    return result;
+  }
+
+  const char* find_quote_scalar(const char* begin, const char* end) {
+    while(begin < end && *begin != '"' && *begin != '\\') begin++;
+    return begin;
+  }
+
+  const char* find_escape_scalar(const char* begin, const char* end, bool ascii) {
+    for(; begin < end; begin++) {
+      const unsigned char c = *begin;
+      if(c < 0x20 || c == '"' || c == '\\' || (ascii && c >= 0x80)) break;
+    }
+
+    return begin;
+  }
+
+  // Length of the well-formed UTF-8 sequence that begins at a non-ASCII
+  // byte, or 0 if it is malformed
+  size_t utf8_sequence(const char* begin, const char* end) {
+    const auto* bytes = (const unsigned char*)begin;
+    const unsigned char lead = bytes[0];
+
+    // Length of the sequence, and the range of its second byte
+    size_t length = 0;
+    unsigned char low = 0x80, high = 0xBF;
+
+    if(lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if(lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      if(lead == 0xE0) low = 0xA0;
+      if(lead == 0xED) high = 0x9F;
+    } else if(lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      if(lead == 0xF0) low = 0x90;
+      if(lead == 0xF4) high = 0x8F;
+    }
+
+    if(!length || (size_t)(end - begin) < length) return 0;
+    if(bytes[1] < low || bytes[1] > high) return 0;
+
+    for(size_t i = 2; i < length; ++i) {
+      if((bytes[i] & 0xC0) != 0x80) return 0;
+    }
+
+    return length;
+  }
+
+  const char* find_invalid_utf8_scalar(const char* begin, const char* end) {
+    while(begin < end) {
+      // Runs of ASCII are skipped a word at a time
+      std::uint64_t word;
+      if(end - begin >= 8 && (std::memcpy(&word, begin, 8), !(word & 0x8080808080808080))) {
+        begin += 8;
+      } else if(!(*begin & 0x80)) {
+        begin++;
+      } else if(const size_t length = utf8_sequence(begin, end)) {
+        begin += length;
+      } else {
+        return begin;
+      }
+    }
+
+    return begin;
+  }
+
+  #if defined(__x86_64__)
+  __attribute__((target("sse2")))
+  std::uint64_t equal_sse2(__m128i chunk, char c) {
+    return (std::uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+  }
+
+  // '{' and '[' (and '}' and ']') differ only in bit 0x20
+  __attribute__((target("sse2")))
+  block classify_sse2(const char* data) {
+    block result{};
+
+    for(int i = 0; i < 4; ++i) {
+      const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + 16 * i));
+      const __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+      const int shift = 16 * i;
+
+      result.quote |= equal_sse2(chunk, '"') << shift;
+      result.backslash |= equal_sse2(chunk, '\\') << shift;
+      const std::uint64_t bracket = equal_sse2(folded, '{') | equal_sse2(folded, '}');
+      result.bracket |= bracket << shift;
+      result.structural |= (bracket | equal_sse2(chunk, ':') | equal_sse2(chunk, ',')) << shift;
+      result.whitespace |= (equal_sse2(chunk, ' ') | equal_sse2(chunk, '\t') |
+                            equal_sse2(chunk, '\n') | equal_sse2(chunk, '\r')) << shift;
+    }
+
+    return result;
+  }
+
+  __attribute__((target("sse2")))
+  const char* find_quote_sse2(const char* begin, const char* end) {
+    for(; end - begin >= 16; begin += 16) {
+      const __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+      const std::uint64_t mask = equal_sse2(chunk, '"') | equal_sse2(chunk, '\\');
+      if(mask) return begin + __builtin_ctzll(mask);
+    }
+
+    return find_quote_scalar(begin, end);
+  }
+
+  // Control characters are those left unchanged by max(c, 0x1f)
+  __attribute__((target("sse2")))
+  const char* find_escape_sse2(const char* begin, const char* end, bool ascii) {
+    const __m128i control = _mm_set1_epi8(0x1f);
+
+    for(; end - begin >= 16; begin += 16) {
+      const __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+      std::uint64_t mask = equal_sse2(chunk, '"') | equal_sse2(chunk, '\\') |
+        (std::uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+      if(ascii) mask |= (std::uint16_t)_mm_movemask_epi8(chunk);
+
+      if(mask) return begin + __builtin_ctzll(mask);
+    }
+
+    return find_escape_scalar(begin, end, ascii);
+  }
+
+  __attribute__((target("avx2")))
+  std::uint64_t equal_avx2(__m256i chunk, char c) {
+    return (std::uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)));
+  }
+
+  __attribute__((target("avx2")))
+  block classify_avx2(const char* data) {
+    block result{};
+
+    for(int i = 0; i < 2; ++i) {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + 32 * i));
+      const __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+      const int shift = 32 * i;
+
+      result.quote |= equal_avx2(chunk, '"') << shift;
+      result.backslash |= equal_avx2(chunk, '\\') << shift;
+      const std::uint64_t bracket = equal_avx2(folded, '{') | equal_avx2(folded, '}');
+      result.bracket |= bracket << shift;
+      result.structural |= (bracket | equal_avx2(chunk, ':') | equal_avx2(chunk, ',')) << shift;
+      result.whitespace |= (equal_avx2(chunk, ' ') | equal_avx2(chunk, '\t') |
+                            equal_avx2(chunk, '\n') | equal_avx2(chunk, '\r')) << shift;
+    }
+
+    return result;
+  }
+
+  __attribute__((target("avx2")))
+  const char* find_quote_avx2(const char* begin, const char* end) {
+    for(; end - begin >= 32; begin += 32) {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+      const std::uint64_t mask = equal_avx2(chunk, '"') | equal_avx2(chunk, '\\');
+      if(mask) return begin + __builtin_ctzll(mask);
+    }
+
+    return find_quote_sse2(begin, end);
+  }
+
+  __attribute__((target("avx2")))
+  const char* find_escape_avx2(const char* begin, const char* end, bool ascii) {
+    const __m256i control = _mm256_set1_epi8(0x1f);
+
+    for(; end - begin >= 32; begin += 32) {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+      std::uint64_t mask = equal_avx2(chunk, '"') | equal_avx2(chunk, '\\') |
+        (std::uint32_t)_mm256_movemask_epi8(
+          _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+      if(ascii) mask |= (std::uint32_t)_mm256_movemask_epi8(chunk);
+
+      if(mask) return begin + __builtin_ctzll(mask);
+    }
+
+    return find_escape_sse2(begin, end, ascii);
+  }
+
+  __attribute__((target("sse2")))
+  const char* find_invalid_utf8_sse2(const char* begin, const char* end) {
+    while(end - begin >= 16) {
+      const __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+      const int mask = _mm_movemask_epi8(chunk);
+      if(!mask) {
+        begin += 16;
+        continue;
+      }
+
+      begin += __builtin_ctz(mask);
+      const size_t length = utf8_sequence(begin, end);
+      if(!length) return begin;
+      begin += length;
+    }
+
+    return find_invalid_utf8_scalar(begin, end);
+  }
+
+  // The lookup algorithm of Keiser and Lemire ("Validating UTF-8 in less
+  // than one instruction per byte", 2021). Each byte is checked against the
+  // one to three before it: three tables indexed by the nibbles of a byte
+  // and of its predecessor flag the errors that pair could be part of, and
+  // an error remains when all three agree. Third and fourth bytes, which
+  // the pairs cannot see, must be continuations exactly where the pairs
+  // flag two continuations in a row.
+  namespace utf8 {
+    constexpr char too_short = 1 << 0;  // 11______ 0_______, 11______ 11______
+    constexpr char too_long = 1 << 1;   // 0_______ 10______
+    constexpr char overlong_3 = 1 << 2; // 11100000 100_____
+    constexpr char too_large = 1 << 3;  // 11110100 1001____, 11110100 101_____, 11110101+
+    constexpr char surrogate = 1 << 4;  // 11101101 101_____
+    constexpr char overlong_2 = 1 << 5; // 1100000_ 10______
+    constexpr char too_large_1000 = 1 << 6; // 11110101+ 1000____
+    constexpr char overlong_4 = 1 << 6; // 11110000 1000____
+    constexpr char two_conts = (char)(1 << 7); // 10______ 10______
+    constexpr char carry = too_short | too_long | two_conts;
+  }
+
+  // The bytes of `input` shifted by n, with the last n bytes of `previous`
+  template<int n>
+  __attribute__((target("avx2")))
+  __m256i preceding(__m256i input, __m256i previous) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - n);
+  }
+
+  __attribute__((target("avx2")))
+  __m256i utf8_errors(__m256i input, __m256i previous) {
+    using namespace utf8;
+
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i prev1 = preceding<1>(input, previous);
+
+    const __m256i byte_1_high = _mm256_shuffle_epi8(_mm256_setr_epi8(
+      too_long, too_long, too_long, too_long,
+      too_long, too_long, too_long, too_long,
+      two_conts, two_conts, two_conts, two_conts,
+      too_short | overlong_2,
+      too_short,
+      too_short | overlong_3 | surrogate,
+      too_short | too_large | too_large_1000 | overlong_4,
+      too_long, too_long, too_long, too_long,
+      too_long, too_long, too_long, too_long,
+      two_conts, two_conts, two_conts, two_conts,
+      too_short | overlong_2,
+      too_short,
+      too_short | overlong_3 | surrogate,
+      too_short | too_large | too_large_1000 | overlong_4),
+      _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+
+    constexpr char large = carry | too_large | too_large_1000;
+    const __m256i byte_1_low = _mm256_shuffle_epi8(_mm256_setr_epi8(
+      carry | overlong_3 | overlong_2 | overlong_4,
+      carry | overlong_2,
+      carry, carry,
+      carry | too_large,
+      large, large, large,
+      large, large, large, large,
+      large, large | surrogate, large, large,
+      carry | overlong_3 | overlong_2 | overlong_4,
+      carry | overlong_2,
+      carry, carry,
+      carry | too_large,
+      large, large, large,
+      large, large, large, large,
+      large, large | surrogate, large, large),
+      _mm256_and_si256(prev1, nibble));
+
+    constexpr char continuation_1000 = too_long | overlong_2 | two_conts | overlong_3 |
+      too_large_1000 | overlong_4;
+    constexpr char continuation_1001 = too_long | overlong_2 | two_conts | overlong_3 | too_large;
+    constexpr char continuation_101 = too_long | overlong_2 | two_conts | surrogate | too_large;
+    const __m256i byte_2_high = _mm256_shuffle_epi8(_mm256_setr_epi8(
+      too_short, too_short, too_short, too_short,
+      too_short, too_short, too_short, too_short,
+      continuation_1000, continuation_1001, continuation_101, continuation_101,
+      too_short, too_short, too_short, too_short,
+      too_short, too_short, too_short, too_short,
+      too_short, too_short, too_short, too_short,
+      continuation_1000, continuation_1001, continuation_101, continuation_101,
+      too_short, too_short, too_short, too_short),
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+
+    const __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Only 111_____ before the previous byte, or 1111____ before that,
+    // stays at or above 0x80 after these subtractions
+    const __m256i third = _mm256_subs_epu8(preceding<2>(input, previous), _mm256_set1_epi8(0xE0 - 0x80));
+    const __m256i fourth = _mm256_subs_epu8(preceding<3>(input, previous), _mm256_set1_epi8(0xF0 - 0x80));
+    const __m256i continuation = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                                  _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(continuation, special);
+  }
+
+  // Finds a chunk with an error, or the last partial one, and then the
+  // exact byte with the scalar search, resuming from the sequence that
+  // crosses into that chunk
+  __attribute__((target("avx2")))
+  const char* find_invalid_utf8_avx2(const char* begin, const char* end) {
+    const char* const start = begin;
+    __m256i previous = _mm256_setzero_si256();
+
+    for(; end - begin >= 32; begin += 32) {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+
+      // An ASCII chunk after an ASCII byte cannot hold an error
+      if(!_mm256_movemask_epi8(chunk) && !(begin > start && (begin[-1] & 0x80))) {
+        previous = chunk;
+        continue;
+      }
+
+      const __m256i errors = utf8_errors(chunk, previous);
+      if(!_mm256_testz_si256(errors, errors)) break;
+      previous = chunk;
+    }
+
+    // Back to the lead byte of a sequence cut by the chunk boundary
+    for(int i = 0; i < 4 && begin > start; ++i) {
+      const bool continuation = (begin[-1] & 0xC0) == 0x80;
+      if(continuation || (begin[-1] & 0x80)) begin--;
+      if(!continuation) break;
+    }
+
+    return find_invalid_utf8_scalar(begin, end);
+  }
+  #endif
+
+  isa detect() {
+    #if defined(__x86_64__)
+    static const isa best = __builtin_cpu_supports("avx2") ? isa::avx2 : isa::sse2;
+    return best;
+    #else
+    return isa::scalar;
+    #endif
+  }
+
+  block classify(const char* data, isa target) {
+    switch(target) {
+      #if defined(__x86_64__)
+      case isa::avx2: return classify_avx2(data);
+      case isa::sse2: return classify_sse2(data);
+      #endif
+      default: return classify_scalar(data);
+    }
+  }
+
+  // Bits of characters preceded by an odd run of backslashes. `carry` is set
+  // when the previous block ended on such a run.
+  std::uint64_t escaped(std::uint64_t backslash, bool& carry) {
+    std::uint64_t result = 0;
+
+    if(carry) {
+      result |= 1;
+      backslash &= ~1ULL;
+    }
+
+    carry = false;
+    while(backslash) {
+      const int i = __builtin_ctzll(backslash);
+      if(i == 63) {
+        carry = true;
+        break;
+      }
+
+      result |= 1ULL << (i + 1);
+      backslash &= ~(3ULL << i);
+    }
+
+    return result;
+  }
+
+  // Inclusive prefix XOR: bit i is the parity of bits 0..i
+  std::uint64_t prefix_xor(std::uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+  bool index(std::string_view text, std::vector<std::uint32_t>& positions,
+             isa target) {
+    positions.clear();
+
+    bool escape = false, in_string = false, in_scalar = false;
+
+    for(size_t offset = 0; offset < text.size(); offset += 64) {
+      const char* data = text.data() + offset;
+
+      // The last partial block is padded with whitespace
+      char padded[64];
+      if(text.size() - offset < 64) {
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, data, text.size() - offset);
+        data = padded;
+      }
+
+      const block chars = classify(data, target);
+
+      const std::uint64_t quotes = chars.quote & ~escaped(chars.backslash, escape);
+
+      // Set from an opening quote up to, but excluding, its closing quote
+      std::uint64_t strings = prefix_xor(quotes);
+      if(in_string) strings = ~strings;
+      in_string = strings >> 63;
+
+      const std::uint64_t structural = chars.structural & ~strings;
+      const std::uint64_t scalar = ~(chars.structural | chars.whitespace |
+                                     quotes | strings);
+      const std::uint64_t scalar_starts = scalar & ~((scalar << 1) | in_scalar);
+      in_scalar = scalar >> 63;
+
+      std::uint64_t bits = structural | quotes | scalar_starts;
+      while(bits) {
+        positions.push_back(offset + __builtin_ctzll(bits));
+        bits &= bits - 1;
+      }
+    }
+
+    return !in_string;
+  }
+
+  const char* skip_container(const char* begin, const char* end, isa target) {
+    bool escape = false, in_string = false;
+    size_t depth = 0;
+
+    for(const char* start = begin; start < end; start += 64) {
+      const char* data = start;
+
+      char padded[64];
+      if(end - start < 64) {
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, data, end - start);
+        data = padded;
+      }
+
+      const block chars = classify(data, target);
+      const std::uint64_t quotes = chars.quote & ~escaped(chars.backslash, escape);
+
+      std::uint64_t strings = prefix_xor(quotes);
+      if(in_string) strings = ~strings;
+      in_string = strings >> 63;
+
+      // Opening brackets have bit 0x02 set, closing ones do not
+      std::uint64_t brackets = chars.bracket & ~strings;
+      while(brackets) {
+        const int i = __builtin_ctzll(brackets);
+        if(data[i] & 0x02) {
+          depth++;
+        } else if(--depth == 0) {
+          return start + i + 1;
+        }
+
+        brackets &= brackets - 1;
+      }
+    }
+
+    return end;
+  }
+
+  // Only blocks that may hold the next split have their commas examined
+  const char* split_container(const char* begin, const char* end, size_t grain,
+                              std::vector<const char*>& commas, isa target) {
+    bool escape = false, in_string = false;
+    size_t depth = 0;
+
+    // Offset from begin past which the next comma is recorded
+    size_t split = grain;
+
+    for(const char* start = begin; start < end; start += 64) {
+      const char* data = start;
+
+      char padded[64];
+      if(end - start < 64) {
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, data, end - start);
+        data = padded;
+      }
+
+      const block chars = classify(data, target);
+      const std::uint64_t quotes = chars.quote & ~escaped(chars.backslash, escape);
+
+      std::uint64_t strings = prefix_xor(quotes);
+      if(in_string) strings = ~strings;
+      in_string = strings >> 63;
+
+      const size_t offset = start - begin;
+      std::uint64_t bits = (offset + 64 > split ? chars.structural : chars.bracket) &
+        ~strings;
+      while(bits) {
+        const int i = __builtin_ctzll(bits);
+
+        switch(data[i]) {
+          case '{': case '[':
+            depth++;
+            break;
+          case '}': case ']':
+            if(--depth == 0) return start + i + 1;
+            break;
+          case ',':
+            if(depth == 1 && offset + i >= split) {
+              commas.push_back(start + i);
+              split = offset + i + grain;
+            }
+            break;
+        }
+
+        bits &= bits - 1;
+      }
+    }
+
+    return nullptr;
+  }
+
+  const char* find_quote(const char* begin, const char* end, isa target) {
+    switch(target) {
+      #if defined(__x86_64__)
+      case isa::avx2: return find_quote_avx2(begin, end);
+      case isa::sse2: return find_quote_sse2(begin, end);
+      #endif
+      default: return find_quote_scalar(begin, end);
+    }
+  }
+
+  const char* find_escape(const char* begin, const char* end, bool ascii,
+                          isa target) {
+    switch(target) {
+      #if defined(__x86_64__)
+      case isa::avx2: return find_escape_avx2(begin, end, ascii);
+      case isa::sse2: return find_escape_sse2(begin, end, ascii);
+      #endif
+      default: return find_escape_scalar(begin, end, ascii);
+    }
+  }
+
+  const char* find_invalid_utf8(const char* begin, const char* end, isa target) {
+    switch(target) {
+      #if defined(__x86_64__)
+      case isa::avx2: return find_invalid_utf8_avx2(begin, end);
+      case isa::sse2: return find_invalid_utf8_sse2(begin, end);
+      #endif
+      default: return find_invalid_utf8_scalar(begin, end);
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Vectorized scanning used by the parser. Each routine has AVX2 and SSE2
+// implementations on x86-64, chosen at runtime, and a portable scalar one.
+namespace json::simd {
+  enum class isa { scalar, sse2, avx2 };
+
+  // Best instruction set supported by the running CPU
+  isa detect();
+
+  // Stage 1 of a parse: records the position of every structural character
+  // ({ } [ ] : ,) and unescaped quote outside of strings, and of the first
+  // byte of every other token (numbers and literals), 64 bytes at a time.
+  // Returns false if the text ends inside a string. Positions are 32-bit, so
+  // the text must be smaller than 4 GiB.
+  bool index(std::string_view text, std::vector<std::uint32_t>& positions,
+             isa target = detect());
+
+  // First '"' or '\\' in [begin, end), or end if there is none
+  const char* find_quote(const char* begin, const char* end,
+                         isa target = detect());
+
+  // Given the opening bracket of an object or array at `begin`, returns one
+  // past its matching closing bracket, or end if there is none. Brackets
+  // inside strings are ignored; nothing else is validated.
+  const char* skip_container(const char* begin, const char* end,
+                             isa target = detect());
+
+  // Like skip_container, but also records commas directly inside the
+  // container, one roughly every `grain` bytes, so that its members or
+  // elements can be divided into ranges. Returns nullptr if the container
+  // is not closed.
+  const char* split_container(const char* begin, const char* end, size_t grain,
+                              std::vector<const char*>& commas,
+                              isa target = detect());
+
+  // First character in [begin, end) that must be escaped in a JSON string
+  // ('"', '\\' or a control character), or that is not ASCII when `ascii`
+  // is set; end if there is none
+  const char* find_escape(const char* begin, const char* end, bool ascii,
+                          isa target = detect());
+
+  // First byte in [begin, end) that does not begin a well-formed UTF-8
+  // sequence (RFC 3629: no overlong forms, surrogates or code points above
+  // U+10FFFF), or end if there is none. Runs of ASCII are skipped a vector
+  // at a time; AVX2 checks the rest with nibble lookup tables.
+  const char* find_invalid_utf8(const char* begin, const char* end,
+                                isa target = detect());
+}
@@ -0,0 +1,511 @@
+#include "json.h"
+#include "file.h"
+#include "reader.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+// A snapshot is a header followed by three sections:
+//
+//   nodes   one snapshot_node per value, in breadth-first order, so that
+//           the members or elements of each container are contiguous
+//   index   for objects of sorted_threshold members or more, the positions
+//           of their members sorted by key, as 32-bit integers (padded to
+//           a multiple of 8 bytes)
+//   pool    the bytes of every distinct string and key
+//
+// All integers are in the byte order of the machine that wrote the file.
+namespace json {
+  namespace {
+    constexpr char magic[8] = { 'J', 'S', 'O', 'N', 'S', 'N', 'A', 'P' };
+    constexpr std::uint32_t version = 1;
+    constexpr std::uint32_t byte_order = 0x01020304;
+
+    // Objects with fewer members are searched linearly
+    constexpr size_t sorted_threshold = 16;
+
+    constexpr std::uint8_t unsigned_number = 1;
+
+    struct header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      // Size of the whole file
+      std::uint64_t size;
+      // Of everything after the header
+      std::uint64_t checksum;
+      std::uint64_t nodes;
+      std::uint64_t index;
+      std::uint64_t pool;
+      std::uint64_t reserved;
+    };
+
+    static_assert(sizeof(header) == 64 && sizeof(json::snapshot_node) == 16);
+
+    size_t padded(size_t size) {
+      return (size + 7) / 8 * 8;
+    }
+
+    // Multiplicative hash over 64-bit words, fast enough to check a file
+    // at the speed it is read from the page cache
+    std::uint64_t checksum(const char* data, size_t size) {
+      std::uint64_t hash = size;
+
+      size_t i = 0;
+      for(; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (std::rotl(hash, 23) ^ word) * 0x9e3779b97f4a7c15;
+      }
+
+      std::uint64_t tail = 0;
+      std::memcpy(&tail, data + i, size - i);
+      hash = (std::rotl(hash, 23) ^ tail) * 0x9e3779b97f4a7c15;
+
+      return hash ^ (hash >> 32);
+    }
+
+    class tape_writer {
+      std::vector<json::snapshot_node> nodes;
+      std::vector<const json::value*> sources;
+      std::vector<std::uint32_t> index;
+      std::string pool;
+      std::unordered_map<std::string_view, std::uint64_t> strings;
+
+      void add(const json::value& value) {
+        nodes.emplace_back();
+        sources.push_back(&value);
+      }
+
+      bool string(std::string_view str, json::snapshot_node& node) {
+        if(str.size() > UINT32_MAX) return false;
+
+        auto [position, added] = strings.try_emplace(str, pool.size());
+        if(added) pool += str;
+
+        node.type = json::value_type::string;
+        node.length = str.size();
+        node.payload = position->second;
+        return true;
+      }
+
+      // Breadth-first, so that the children of a node are added together
+      bool flatten(const json::value& root) {
+        add(root);
+
+        for(size_t i = 0; i < nodes.size(); ++i) {
+          const json::value& value = *sources[i];
+          json::snapshot_node node = {};
+
+          if(value.is_object()) {
+            const json::object_type& members = value.members();
+            node.type = json::value_type::object;
+            node.length = members.size();
+            node.payload = nodes.size();
+
+            if(members.size() >= sorted_threshold) {
+              node.payload |= (std::uint64_t)index.size() << 32;
+
+              const size_t start = index.size();
+              for(size_t j = 0; j < members.size(); ++j) index.push_back(j);
+
+              auto first = members.begin();
+              std::sort(index.begin() + start, index.end(), [first](std::uint32_t a, std::uint32_t b) {
+                return first[a].first.as_string_view() < first[b].first.as_string_view();
+              });
+            }
+
+            for(const auto& [key, element] : members) {
+              add(key);
+              add(element);
+            }
+          } else if(value.is_array()) {
+            node.type = json::value_type::array;
+            node.length = value.elements().size();
+            node.payload = nodes.size();
+
+            for(const json::value& element : value.elements()) add(element);
+          } else if(value.is_string()) {
+            if(!string(value.as_string_view(), node)) return false;
+          } else if(value.is_float()) {
+            node.type = json::value_type::floating;
+            node.payload = std::bit_cast<std::uint64_t>(value.as_double());
+          } else if(value.is_integer()) {
+            node.type = json::value_type::integer;
+            node.flags = value.is_unsigned() ? unsigned_number : 0;
+            node.payload = value.as_uint64();
+          } else if(value.is_bool()) {
+            node.type = value ? json::value_type::true_literal : json::value_type::false_literal;
+          } else {
+            node.type = value.is_null() ? json::value_type::null_literal : json::value_type::undefined;
+          }
+
+          nodes[i] = node;
+        }
+
+        return nodes.size() <= UINT32_MAX && index.size() <= UINT32_MAX;
+      }
+
+      public:
+        // Returns an error message, or nullptr
+        const char* write(const json::value& root, std::string& output) {
+          if(!flatten(root)) return "snapshot: document too large";
+
+          const size_t nodes_size = nodes.size() * sizeof(json::snapshot_node);
+          const size_t index_size = padded(index.size() * sizeof(std::uint32_t));
+
+          header head = {};
+          std::memcpy(head.magic, magic, sizeof(magic));
+          head.version = version;
+          head.byte_order = byte_order;
+          head.size = sizeof(header) + nodes_size + index_size + pool.size();
+          head.nodes = nodes.size();
+          head.index = index.size();
+          head.pool = pool.size();
+
+          output.assign(head.size, '\0');
+          char* body = output.data() + sizeof(header);
+          std::memcpy(body, nodes.data(), nodes_size);
+          std::memcpy(body + nodes_size, index.data(), index.size() * sizeof(std::uint32_t));
+          std::memcpy(body + nodes_size + index_size, pool.data(), pool.size());
+
+          head.checksum = checksum(body, head.size - sizeof(header));
+          std::memcpy(output.data(), &head, sizeof(header));
+
+          return nullptr;
+        }
+    };
+  }
+
+  std::string to_snapshot(const json::value& value) {
+    std::string output;
+
+    const char* msg = tape_writer().write(value, output);
+
+    #ifndef NO_EXCEPTIONS
+    if(msg) throw json::exception(msg);
+    #else
+    if(msg) output.clear();
+    #endif
+
+    return output;
+  }
+
+  bool save_snapshot(const json::value& value, const std::filesystem::path& filename) {
+    const std::string bytes = json::to_snapshot(value);
+
+    const char* msg = nullptr;
+    if(bytes.empty()) {
+      msg = "snapshot: document too large";
+    } else {
+      std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+      if(!file.write(bytes.data(), bytes.size())) msg = "snapshot: cannot write file";
+    }
+
+    if(!msg) return true;
+
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    return false;
+    #endif
+  }
+
+  snapshot::snapshot() : file(std::make_unique<json::mapped_file>()) {}
+
+  snapshot::~snapshot() = default;
+
+  bool snapshot::fail(const char* msg) {
+    close();
+    message = msg;
+
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    return false;
+    #endif
+  }
+
+  bool snapshot::load(const std::filesystem::path& filename) {
+    close();
+    if(const char* msg = file->open(filename)) return fail(msg);
+    return map(file->text());
+  }
+
+  bool snapshot::read(std::string_view bytes) {
+    close();
+    return map(bytes);
+  }
+
+  bool snapshot::map(std::string_view bytes) {
+    header head;
+    if(bytes.size() < sizeof(header)) return fail("snapshot: not a snapshot");
+    std::memcpy(&head, bytes.data(), sizeof(header));
+
+    if(std::memcmp(head.magic, magic, sizeof(magic)) != 0) return fail("snapshot: not a snapshot");
+    if(head.version != version) return fail("snapshot: unsupported version");
+    if(head.byte_order != byte_order) return fail("snapshot: written with another byte order");
+
+    const size_t nodes_size = head.nodes * sizeof(json::snapshot_node);
+    const size_t index_size = padded(head.index * sizeof(std::uint32_t));
+
+    if(head.size != bytes.size() || head.nodes == 0 || head.nodes > UINT32_MAX ||
+       head.index > UINT32_MAX || head.pool > bytes.size() ||
+       sizeof(header) + nodes_size + index_size + head.pool != bytes.size()) {
+      return fail("snapshot: truncated or damaged");
+    }
+
+    if((std::uintptr_t)bytes.data() % 8) return fail("snapshot: data must be 8-byte aligned");
+
+    const char* body = bytes.data() + sizeof(header);
+    if(checksum(body, bytes.size() - sizeof(header)) != head.checksum) {
+      return fail("snapshot: checksum mismatch");
+    }
+
+    sections.nodes = (const json::snapshot_node*)body;
+    sections.index = (const std::uint32_t*)(body + nodes_size);
+    sections.pool = body + nodes_size + index_size;
+
+    return true;
+  }
+
+  void snapshot::close() {
+    file->close();
+    sections = {};
+    message = nullptr;
+  }
+
+  snapshot_value snapshot::root() const {
+    if(!sections.nodes) return snapshot_value::fail(message ? message : "snapshot: not open");
+    return snapshot_value(&sections, sections.nodes);
+  }
+
+  snapshot_value snapshot_value::fail(const char* msg) {
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(msg);
+    #else
+    snapshot_value result;
+    result.message = msg;
+    return result;
+    #endif
+  }
+
+  const snapshot_node* snapshot_value::first() const {
+    return sections->nodes + (std::uint32_t)node->payload;
+  }
+
+  bool snapshot_value::is_object() const {
+    return node && node->type == json::value_type::object;
+  }
+
+  bool snapshot_value::is_array() const {
+    return node && node->type == json::value_type::array;
+  }
+
+  bool snapshot_value::is_bool() const {
+    return node && (node->type == json::value_type::true_literal ||
+                    node->type == json::value_type::false_literal);
+  }
+
+  bool snapshot_value::is_string() const {
+    return node && node->type == json::value_type::string;
+  }
+
+  bool snapshot_value::is_number() const {
+    return is_integer() || is_float();
+  }
+
+  bool snapshot_value::is_integer() const {
+    return node && node->type == json::value_type::integer;
+  }
+
+  bool snapshot_value::is_float() const {
+    return node && node->type == json::value_type::floating;
+  }
+
+  bool snapshot_value::is_null() const {
+    return node && node->type == json::value_type::null_literal;
+  }
+
+  size_t snapshot_value::size() const {
+    return is_object() || is_array() || is_string() ? node->length : 0;
+  }
+
+  std::optional<snapshot_value> snapshot_value::find(std::string_view key) const {
+    if(!is_object()) return std::nullopt;
+
+    const snapshot_node* members = first();
+    auto key_of = [this, members](size_t position) {
+      return snapshot_value(sections, members + position * 2).as_string_view();
+    };
+
+    if(node->length < sorted_threshold) {
+      for(size_t i = 0; i < node->length; ++i) {
+        if(key_of(i) == key) return snapshot_value(sections, members + i * 2 + 1);
+      }
+
+      return std::nullopt;
+    }
+
+    const std::uint32_t* sorted = sections->index + (node->payload >> 32);
+    const std::uint32_t* last = sorted + node->length;
+    const std::uint32_t* found = std::lower_bound(sorted, last, key,
+      [&key_of](std::uint32_t position, std::string_view key) {
+        return key_of(position) < key;
+      });
+
+    if(found == last || key_of(*found) != key) return std::nullopt;
+    return snapshot_value(sections, members + *found * 2 + 1);
+  }
+
+  snapshot_value snapshot_value::operator[](std::string_view key) const {
+    return find(key).value_or(snapshot_value());
+  }
+
+  snapshot_value snapshot_value::operator[](size_t i) const {
+    return at(i);
+  }
+
+  snapshot_value snapshot_value::at(std::string_view key) const {
+    if(std::optional<snapshot_value> member = find(key)) return *member;
+    return fail("object key not found");
+  }
+
+  snapshot_value snapshot_value::at(size_t i) const {
+    if(!is_array() || i >= node->length) return fail("array index out of bounds");
+    return snapshot_value(sections, first() + i);
+  }
+
+  snapshot_value snapshot_value::at_pointer(std::string_view pointer) const {
+    return at_pointer(json::path(pointer));
+  }
+
+  snapshot_value snapshot_value::at_pointer(const json::path& path) const {
+    if(path.message) return fail(path.message);
+
+    snapshot_value current = *this;
+    for(size_t i = 0; i < path.size(); ++i) {
+      std::optional<snapshot_value> next;
+
+      if(current.is_object()) {
+        next = current.find(path.name(i));
+      } else if(current.is_array() && path.tokens[i].index < current.size()) {
+        next = current.at(path.tokens[i].index);
+      }
+
+      if(!next) return fail("pointer: no value at path");
+      current = *next;
+    }
+
+    return current;
+  }
+
+  snapshot_range<snapshot_member> snapshot_value::members() const {
+    if(!is_object()) return {};
+    return {sections, first(), node->length};
+  }
+
+  snapshot_range<snapshot_value> snapshot_value::elements() const {
+    if(!is_array()) return {};
+    return {sections, first(), node->length};
+  }
+
+  std::string_view snapshot_value::as_string_view() const {
+    if(!is_string()) return {};
+    return std::string_view(sections->pool + node->payload, node->length);
+  }
+
+  bool snapshot_value::is_unsigned() const {
+    return is_integer() && (node->flags & unsigned_number);
+  }
+
+  std::int64_t snapshot_value::as_int64() const {
+    if(is_integer()) return (std::int64_t)node->payload;
+    if(is_float()) return (std::int64_t)as_double();
+    return 0;
+  }
+
+  std::uint64_t snapshot_value::as_uint64() const {
+    if(is_integer()) return node->payload;
+    if(is_float()) return (std::uint64_t)as_double();
+    return 0;
+  }
+
+  double snapshot_value::as_double() const {
+    if(is_float()) return std::bit_cast<double>(node->payload);
+    if(is_unsigned()) return (double)node->payload;
+    if(is_integer()) return (double)(std::int64_t)node->payload;
+    return 0;
+  }
+
+  namespace {
+    json::value copy(const snapshot_value& view, builder& build) {
+      if(view.is_object()) {
+        json::value result = build.object();
+        build.reserve(result, view.size());
+
+        for(const auto& [key, value] : view.members()) {
+          build.insert(result, build.key(key, false), copy(value, build));
+        }
+
+        return result;
+      }
+
+      if(view.is_array()) {
+        json::value result = build.array();
+        build.reserve(result, view.size());
+
+        for(const snapshot_value& element : view.elements()) {
+          build.append(result, copy(element, build));
+        }
+
+        return result;
+      }
+
+      if(view.is_string()) return build.string(view.as_string_view());
+      if(view.is_float()) return json::value(view.as_double());
+      if(view.is_unsigned()) return json::value(view.as_uint64());
+      if(view.is_integer()) return json::value(view.as_int64());
+      if(view.is_bool()) return json::value((bool)view);
+      if(view.is_null()) return json::value(json::value_type::null_literal);
+      return json::value(json::value_type::undefined);
+    }
+  }
+
+  json::value snapshot_value::materialize() const {
+    builder build;
+    return copy(*this, build);
+  }
+
+  std::string snapshot_value::to_string(const json::write_options& options) const {
+    return materialize().to_string(options);
+  }
+
+  snapshot_value::operator std::string() const {
+    if(is_string()) return std::string(as_string_view());
+    return to_string();
+  }
+
+  snapshot_value::operator int() const {
+    if(is_integer()) return (int)as_int64();
+    if(is_float()) return (int)as_double();
+    return is_bool() && node->type == json::value_type::true_literal;
+  }
+
+  snapshot_value::operator bool() const {
+    return node && !(node->type == json::value_type::false_literal ||
+                     node->type == json::value_type::undefined);
+  }
+
+  snapshot_value::operator double() const {
+    return as_double();
+  }
+
+  #ifdef NO_EXCEPTIONS
+  bool snapshot_value::error() const {
+    return !node || node->type == json::value_type::undefined;
+  }
+  #endif
+}
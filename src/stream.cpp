@@ -0,0 +1,88 @@
+#include "json.h"
+#include "reader.h"
+
+namespace json {
+  class parser::state {
+    public:
+      virtual ~state() = default;
+
+      virtual bool feed(std::string_view chunk, bool last) = 0;
+      virtual bool done() const = 0;
+      virtual const char* error() const = 0;
+      virtual json::value& root() = 0;
+  };
+
+  namespace {
+    class tree_state : public parser::state {
+      builder build;
+      tree_handler handler{build};
+      stream_reader<tree_handler> read{handler, build.resource()};
+
+      public:
+        bool feed(std::string_view chunk, bool last) override {
+          return read.feed(chunk, last);
+        }
+
+        bool done() const override { return read.done(); }
+        const char* error() const override { return read.error(); }
+        json::value& root() override { return handler.result(); }
+    };
+
+    class event_state : public parser::state {
+      event_handler handler;
+      stream_reader<event_handler> read{handler};
+      json::value tree;
+
+      public:
+        explicit event_state(json::handler& events) : handler(events) {}
+
+        bool feed(std::string_view chunk, bool last) override {
+          return read.feed(chunk, last);
+        }
+
+        bool done() const override { return read.done(); }
+        const char* error() const override { return read.error(); }
+        json::value& root() override { return tree; }
+    };
+  }
+
+  parser::parser() : impl(new tree_state()) {}
+
+  parser::parser(json::handler& handler) : impl(new event_state(handler)) {}
+
+  parser::~parser() = default;
+
+  parser::parser(parser&& other) noexcept = default;
+
+  parser& parser::operator=(parser&& other) noexcept = default;
+
+  bool parser::read(std::string_view chunk, bool last) {
+    if(impl->feed(chunk, last)) return true;
+
+    if(const char* msg = impl->error()) {
+      #ifndef NO_EXCEPTIONS
+      throw json::exception(msg);
+      #else
+      impl->root() = json::error(msg);
+      #endif
+    }
+
+    return false;
+  }
+
+  bool parser::feed(std::string_view chunk) {
+    return read(chunk, false);
+  }
+
+  bool parser::finish() {
+    return read({}, true);
+  }
+
+  bool parser::done() const {
+    return impl->done();
+  }
+
+  json::value& parser::root() {
+    return impl->root();
+  }
+}
@@ -0,0 +1,266 @@
+#include "typed.h"
+#include "reader.h"
+
+#include <charconv>
+
+namespace json {
+  namespace {
+    // Accepts every value, for skipping
+    struct skip_handler {
+      bool object_begin() { return true; }
+      bool object_end() { return true; }
+      bool array_begin() { return true; }
+      bool array_end() { return true; }
+      bool key(const text_token&) { return true; }
+      bool string(const text_token&) { return true; }
+      bool number(std::string_view, bool) { return true; }
+      bool literal(json::value_type) { return true; }
+    };
+  }
+
+  class cursor::state {
+    public:
+      string_iterator text;
+
+      // Decoding buffer for escaped strings, reused across the whole read
+      std::pmr::string scratch;
+
+      // Whether a key or element may come next, as after an opening
+      // bracket or a comma
+      bool ready = false;
+
+      const char* message = nullptr;
+      size_t offset = 0;
+
+      explicit state(std::string_view input) : text(input) {}
+
+      bool fail(const char* msg) {
+        message = msg;
+        offset = text.position();
+        return false;
+      }
+
+      // Skips whitespace up to the next token, unless the cursor stopped
+      bool next() {
+        if(message) return false;
+
+        text.skip_whitespace();
+        return true;
+      }
+
+      // Reads a number, leaving its lexeme
+      bool number(std::string_view& lexeme, bool& floating) {
+        if(!next()) return false;
+
+        if(text.peek() != '-' && !is_digit(text.peek())) {
+          return fail("converting: expected a number");
+        }
+
+        const size_t begin = text.position();
+        if(const char* msg = read_number(text, floating)) return fail(msg);
+
+        lexeme = text.slice(begin);
+        ready = false;
+        return true;
+      }
+
+      template<typename Integer>
+      bool integer(Integer& number) {
+        std::string_view lexeme;
+        bool floating;
+
+        if(!this->number(lexeme, floating)) return false;
+        if(floating) return fail("converting: expected an integer");
+
+        const char* end = lexeme.data() + lexeme.size();
+        if(std::from_chars(lexeme.data(), end, number).ec != std::errc()) {
+          return fail("converting: number out of range");
+        }
+
+        return true;
+      }
+
+      template<typename Handler>
+      bool value(Handler& handler) {
+        if(!next()) return false;
+
+        reader<Handler> read{text, handler};
+        if(!read.value()) {
+          message = read.error();
+          offset = read.error_offset();
+          return false;
+        }
+
+        ready = false;
+        return true;
+      }
+  };
+
+  cursor::cursor(std::string_view text) : impl(new state(text)) {}
+
+  cursor::~cursor() = default;
+
+  bool cursor::begin_object() {
+    if(!impl->next()) return false;
+    if(impl->text.peek() != '{') return impl->fail("converting: expected an object");
+
+    impl->text.next();
+    impl->ready = true;
+    return true;
+  }
+
+  // Leading, trailing and repeated commas are tolerated, as in parse
+  bool cursor::next_key(std::string_view& key) {
+    string_iterator& text = impl->text;
+
+    while(impl->next()) {
+      switch(text.peek()) {
+        case ',':
+          impl->ready = true;
+          text.next();
+          continue;
+        case '}':
+          text.next();
+          impl->ready = false;
+          return false;
+        case '"':
+          if(impl->ready) break;
+          [[fallthrough]];
+        default:
+          return impl->fail(text.available() ?
+            "parsing: invalid object" : "parsing: unterminated object");
+      }
+
+      text_token token;
+      if(const char* msg = read_text(text, impl->scratch, token)) {
+        return impl->fail(msg);
+      }
+
+      text.skip_whitespace();
+      if(text.peek() != ':') return impl->fail("parsing: object key does not have value");
+      text.next();
+
+      key = token.text;
+      return true;
+    }
+
+    return false;
+  }
+
+  bool cursor::begin_array() {
+    if(!impl->next()) return false;
+    if(impl->text.peek() != '[') return impl->fail("converting: expected an array");
+
+    impl->text.next();
+    impl->ready = true;
+    return true;
+  }
+
+  bool cursor::next_element() {
+    string_iterator& text = impl->text;
+
+    while(impl->next()) {
+      switch(text.peek()) {
+        case ',':
+          impl->ready = true;
+          text.next();
+          continue;
+        case ']':
+          text.next();
+          impl->ready = false;
+          return false;
+        default:
+          if(!impl->ready || !text.available()) {
+            return impl->fail(text.available() ?
+              "parsing: invalid array" : "parsing: unterminated array");
+          }
+          return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool cursor::null() {
+    if(!impl->next() || impl->text.peek() != 'n') return false;
+
+    json::value_type type;
+    if(const char* msg = read_literal(impl->text, type)) return impl->fail(msg);
+
+    impl->ready = false;
+    return true;
+  }
+
+  bool cursor::read(bool& boolean) {
+    if(!impl->next()) return false;
+
+    const char c = impl->text.peek();
+    if(c != 't' && c != 'f') return impl->fail("converting: expected a boolean");
+
+    json::value_type type;
+    if(const char* msg = read_literal(impl->text, type)) return impl->fail(msg);
+
+    boolean = type == json::value_type::true_literal;
+    impl->ready = false;
+    return true;
+  }
+
+  bool cursor::read(std::int64_t& number) {
+    return impl->integer(number);
+  }
+
+  bool cursor::read(std::uint64_t& number) {
+    return impl->integer(number);
+  }
+
+  bool cursor::read(double& number) {
+    std::string_view lexeme;
+    bool floating;
+
+    if(!impl->number(lexeme, floating)) return false;
+
+    number = convert_number(lexeme, floating).as_double();
+    return true;
+  }
+
+  bool cursor::read(std::string& str) {
+    if(!impl->next()) return false;
+    if(impl->text.peek() != '"') return impl->fail("converting: expected a string");
+
+    text_token token;
+    if(const char* msg = read_text(impl->text, impl->scratch, token)) {
+      return impl->fail(msg);
+    }
+
+    str.assign(token.text);
+    impl->ready = false;
+    return true;
+  }
+
+  bool cursor::read(json::value& value) {
+    builder build;
+    tree_handler handler{build};
+    if(!impl->value(handler)) return false;
+
+    value = std::move(handler.result());
+    return true;
+  }
+
+  bool cursor::skip() {
+    skip_handler handler;
+    return impl->value(handler);
+  }
+
+  bool cursor::fail(const char* message) {
+    if(!impl->message) impl->fail(message);
+    return false;
+  }
+
+  const char* cursor::error() const {
+    return impl->message;
+  }
+
+  size_t cursor::error_offset() const {
+    return impl->offset;
+  }
+}
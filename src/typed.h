@@ -0,0 +1,342 @@
+#pragma once
+
+#include "json.h"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Reading JSON straight into C++ types, and writing them back, without an
+// intermediate json::value. Structs declare their members with JSON_FIELDS
+// at namespace scope, next to the struct:
+//
+//   struct image { int width; std::string title; std::vector<int> ids; };
+//   JSON_FIELDS(image, width, title, ids)
+//
+//   image thumbnail = json::parse_into<image>(text);
+//   std::string text = json::serialize(thumbnail);
+//
+// Other types are supported by specializing json::mapping.
+namespace json {
+  // Pull parser over JSON text: the caller asks for the value it expects
+  // next, and the cursor reads it in place. Every call returns false when
+  // the input is malformed or does not hold what was asked for, and
+  // error() then describes why; the cursor must not be used afterwards.
+  // Grammar and leniency are those of json::parse. Nothing is allocated
+  // per value, except for strings that contain escapes.
+  class cursor {
+    public:
+      class state;
+
+      explicit cursor(std::string_view text);
+      ~cursor();
+
+      cursor(const cursor&) = delete;
+      cursor& operator=(const cursor&) = delete;
+
+      // Enters an object; its members are then read with next_key
+      bool begin_object();
+      // Reads the key of the next member, or leaves the object and returns
+      // false at its end. The key is only valid until the next call.
+      bool next_key(std::string_view& key);
+
+      // Enters an array; its elements are then read after next_element
+      bool begin_array();
+      // Whether another element follows; leaves the array at its end
+      bool next_element();
+
+      // Reads a null if one comes next; otherwise reads nothing and returns
+      // false
+      bool null();
+
+      bool read(bool& boolean);
+      bool read(std::int64_t& number);
+      bool read(std::uint64_t& number);
+      bool read(double& number);
+      bool read(std::string& str);
+      // Builds a tree of the next value
+      bool read(json::value& value);
+
+      // Reads the next value without storing it
+      bool skip();
+
+      // Stops the cursor with an error; the message must outlive it
+      bool fail(const char* message);
+
+      const char* error() const;
+      size_t error_offset() const;
+
+    private:
+      std::unique_ptr<state> impl;
+  };
+
+  // Reads and writes a T. Specializations provide
+  //
+  //   static bool read(json::cursor& cursor, T& object);
+  //   static void write(json::writer& writer, const T& object);
+  template<typename T, typename = void>
+  struct mapping;
+
+  template<typename T>
+  bool read(json::cursor& cursor, T& object) {
+    return json::mapping<T>::read(cursor, object);
+  }
+
+  template<typename T>
+  void write(json::writer& writer, const T& object) {
+    json::mapping<T>::write(writer, object);
+  }
+
+  // A struct member declared with JSON_FIELDS
+  template<typename Class, typename Member>
+  struct field {
+    std::string_view name;
+    Member Class::* member;
+  };
+
+  template<typename Class, typename Member>
+  constexpr json::field<Class, Member> make_field(std::string_view name,
+                                                  Member Class::* member) {
+    return {name, member};
+  }
+
+  // Types with members declared by JSON_FIELDS
+  template<typename T>
+  concept record = requires(const T* object) { json_fields(object); };
+
+  template<>
+  struct mapping<bool> {
+    static bool read(json::cursor& cursor, bool& boolean) {
+      return cursor.read(boolean);
+    }
+
+    static void write(json::writer& writer, bool boolean) {
+      writer.value(boolean);
+    }
+  };
+
+  // Integers out of the range of the target type are errors
+  template<typename T>
+  struct mapping<T, std::enable_if_t<std::is_integral_v<T>>> {
+    using wide = std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>;
+
+    static bool read(json::cursor& cursor, T& number) {
+      wide result;
+      if(!cursor.read(result)) return false;
+      if(!std::in_range<T>(result)) return cursor.fail("converting: number out of range");
+
+      number = (T)result;
+      return true;
+    }
+
+    static void write(json::writer& writer, T number) {
+      writer.value((wide)number);
+    }
+  };
+
+  template<typename T>
+  struct mapping<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static bool read(json::cursor& cursor, T& number) {
+      double result;
+      if(!cursor.read(result)) return false;
+
+      number = (T)result;
+      return true;
+    }
+
+    static void write(json::writer& writer, T number) {
+      writer.value((double)number);
+    }
+  };
+
+  template<>
+  struct mapping<std::string> {
+    static bool read(json::cursor& cursor, std::string& str) {
+      return cursor.read(str);
+    }
+
+    static void write(json::writer& writer, const std::string& str) {
+      writer.value(str);
+    }
+  };
+
+  template<>
+  struct mapping<json::value> {
+    static bool read(json::cursor& cursor, json::value& value) {
+      return cursor.read(value);
+    }
+
+    static void write(json::writer& writer, const json::value& value) {
+      writer.value(value);
+    }
+  };
+
+  // null when empty
+  template<typename T>
+  struct mapping<std::optional<T>> {
+    static bool read(json::cursor& cursor, std::optional<T>& optional) {
+      if(cursor.null()) {
+        optional.reset();
+        return true;
+      }
+
+      return json::read(cursor, optional.emplace());
+    }
+
+    static void write(json::writer& writer, const std::optional<T>& optional) {
+      if(optional) {
+        json::write(writer, *optional);
+      } else {
+        writer.null();
+      }
+    }
+  };
+
+  template<typename T, typename Allocator>
+  struct mapping<std::vector<T, Allocator>> {
+    static bool read(json::cursor& cursor, std::vector<T, Allocator>& vector) {
+      if(!cursor.begin_array()) return false;
+
+      vector.clear();
+      while(cursor.next_element()) {
+        if(!json::read(cursor, vector.emplace_back())) return false;
+      }
+
+      return !cursor.error();
+    }
+
+    static void write(json::writer& writer, const std::vector<T, Allocator>& vector) {
+      writer.begin_array();
+      for(const T& element : vector) json::write(writer, element);
+      writer.end_array();
+    }
+  };
+
+  template<typename T, typename Compare, typename Allocator>
+  struct mapping<std::map<std::string, T, Compare, Allocator>> {
+    using map = std::map<std::string, T, Compare, Allocator>;
+
+    static bool read(json::cursor& cursor, map& members) {
+      if(!cursor.begin_object()) return false;
+
+      members.clear();
+      std::string_view key;
+      while(cursor.next_key(key)) {
+        if(!json::read(cursor, members[std::string(key)])) return false;
+      }
+
+      return !cursor.error();
+    }
+
+    static void write(json::writer& writer, const map& members) {
+      writer.begin_object();
+      for(const auto& [key, value] : members) {
+        writer.key(key);
+        json::write(writer, value);
+      }
+      writer.end_object();
+    }
+  };
+
+  // Members are matched by name; unknown keys are skipped and members
+  // whose key is absent keep their value
+  template<json::record T>
+  struct mapping<T> {
+    static bool read(json::cursor& cursor, T& object) {
+      if(!cursor.begin_object()) return false;
+
+      constexpr auto fields = json_fields((const T*)nullptr);
+
+      std::string_view key;
+      while(cursor.next_key(key)) {
+        bool found = false, ok = true;
+
+        std::apply([&](const auto&... field) {
+          ((!found && field.name == key &&
+            (found = true, ok = json::read(cursor, object.*field.member))), ...);
+        }, fields);
+
+        if(!found) ok = cursor.skip();
+        if(!ok) return false;
+      }
+
+      return !cursor.error();
+    }
+
+    static void write(json::writer& writer, const T& object) {
+      writer.begin_object();
+
+      std::apply([&](const auto&... field) {
+        ((writer.key(field.name), json::write(writer, object.*field.member)), ...);
+      }, json_fields((const T*)nullptr));
+
+      writer.end_object();
+    }
+  };
+
+  // Reads text into `result`. Malformed input and values that do not fit
+  // their target throw json::exception (return false with NO_EXCEPTIONS).
+  // As with parse, input after the value is ignored.
+  template<typename T>
+  bool parse_into(std::string_view text, T& result) {
+    json::cursor cursor{text};
+    if(json::read(cursor, result)) return true;
+
+    #ifndef NO_EXCEPTIONS
+    throw json::exception(cursor.error());
+    #else
+    return false;
+    #endif
+  }
+
+  #ifndef NO_EXCEPTIONS
+  template<typename T>
+  T parse_into(std::string_view text) {
+    T result{};
+    json::parse_into(text, result);
+    return result;
+  }
+  #endif
+
+  template<typename T>
+  std::string serialize(const T& object, const json::write_options& options = {}) {
+    std::string output;
+    {
+      json::writer writer{output, options};
+      json::write(writer, object);
+    }
+    return output;
+  }
+}
+
+// JSON_FIELDS(Type, member...) declares the members of a struct that are
+// read and written, under their own names. Up to 256 members are supported.
+#define JSON_FIELDS(Type, ...) \
+  [[maybe_unused]] constexpr auto json_fields(const Type*) { \
+    using json_record = Type; \
+    return std::make_tuple(JSON_FIELDS_EACH(JSON_FIELDS_FIELD, __VA_ARGS__)); \
+  }
+
+#define JSON_FIELDS_FIELD(member) json::make_field(#member, &json_record::member)
+
+#define JSON_FIELDS_EACH(macro, ...) \
+  __VA_OPT__(JSON_FIELDS_EXPAND(JSON_FIELDS_NEXT(macro, __VA_ARGS__)))
+#define JSON_FIELDS_NEXT(macro, first, ...) \
+  macro(first) __VA_OPT__(, JSON_FIELDS_AGAIN JSON_FIELDS_PARENS (macro, __VA_ARGS__))
+#define JSON_FIELDS_AGAIN() JSON_FIELDS_NEXT
+#define JSON_FIELDS_PARENS ()
+
+#define JSON_FIELDS_EXPAND(...) JSON_FIELDS_EXPAND4(JSON_FIELDS_EXPAND4( \
+  JSON_FIELDS_EXPAND4(JSON_FIELDS_EXPAND4(__VA_ARGS__))))
+#define JSON_FIELDS_EXPAND4(...) JSON_FIELDS_EXPAND3(JSON_FIELDS_EXPAND3( \
+  JSON_FIELDS_EXPAND3(JSON_FIELDS_EXPAND3(__VA_ARGS__))))
+#define JSON_FIELDS_EXPAND3(...) JSON_FIELDS_EXPAND2(JSON_FIELDS_EXPAND2( \
+  JSON_FIELDS_EXPAND2(JSON_FIELDS_EXPAND2(__VA_ARGS__))))
+#define JSON_FIELDS_EXPAND2(...) JSON_FIELDS_EXPAND1(JSON_FIELDS_EXPAND1( \
+  JSON_FIELDS_EXPAND1(JSON_FIELDS_EXPAND1(__VA_ARGS__))))
+#define JSON_FIELDS_EXPAND1(...) __VA_ARGS__
@@ -0,0 +1,369 @@
+#include "json.h"
+#include "simd.h"
+
+#include <charconv>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace json {
+  // Output for sinks other than a string is handed over in blocks of this size
+  constexpr size_t block_size = 64 * 1024;
+
+  namespace {
+    // Whether the innermost open container was opened with `open`
+    bool balanced(const std::string& stack, char open) {
+      if(!stack.empty() && stack.back() == open) return true;
+
+      #ifndef NO_EXCEPTIONS
+      throw json::exception("writing: unbalanced end_object/end_array");
+      #else
+      return false;
+      #endif
+    }
+  }
+
+  writer::writer(std::string& output, const json::write_options& options) :
+    output(&output), options(options) {}
+
+  writer::writer(std::ostream& stream, const json::write_options& options) :
+    writer([&stream](std::string_view text) {
+      stream.write(text.data(), text.size());
+    }, options) {}
+
+  writer::writer(int fd, const json::write_options& options) :
+    writer([fd](std::string_view text) {
+      #if defined(__unix__) || defined(__APPLE__)
+      while(!text.empty()) {
+        const ssize_t count = ::write(fd, text.data(), text.size());
+        if(count < 0 && errno == EINTR) continue;
+
+        if(count < 0) {
+          #ifndef NO_EXCEPTIONS
+          throw json::exception("writing: cannot write to file");
+          #else
+          return;
+          #endif
+        }
+
+        text.remove_prefix(count);
+      }
+      #endif
+    }, options) {}
+
+  writer::writer(std::function<void(std::string_view)> callback,
+                 const json::write_options& options) :
+    output(&buffer), drain(std::move(callback)), options(options) {
+    buffer.reserve(block_size);
+  }
+
+  // Errors cannot be reported from here, so they are dropped
+  writer::~writer() {
+    #ifndef NO_EXCEPTIONS
+    try {
+      flush();
+    } catch(...) {}
+    #else
+    flush();
+    #endif
+  }
+
+  void writer::flush() {
+    if(!drain || buffer.empty()) return;
+
+    drain(buffer);
+    buffer.clear();
+  }
+
+  void writer::put(std::string_view text) {
+    output->append(text);
+    if(drain && buffer.size() >= block_size) flush();
+  }
+
+  void writer::put(char c) {
+    output->push_back(c);
+    if(drain && buffer.size() >= block_size) flush();
+  }
+
+  // Writes the separator that precedes a key or a value
+  void writer::separate() {
+    if(after_key) {
+      after_key = false;
+      return;
+    }
+
+    if(!first && !stack.empty()) put(", ");
+    first = false;
+  }
+
+  writer& writer::begin_object() {
+    separate();
+    put("{ ");
+    stack.push_back('{');
+    first = true;
+    return *this;
+  }
+
+  writer& writer::end_object() {
+    if(!balanced(stack, '{')) return *this;
+
+    put(" }");
+    stack.pop_back();
+    first = false;
+    return *this;
+  }
+
+  writer& writer::begin_array() {
+    separate();
+    put('[');
+    stack.push_back('[');
+    first = true;
+    return *this;
+  }
+
+  writer& writer::end_array() {
+    if(!balanced(stack, '[')) return *this;
+
+    put(']');
+    stack.pop_back();
+    first = false;
+    return *this;
+  }
+
+  writer& writer::key(std::string_view key) {
+    separate();
+    string(key);
+    put(": ");
+    after_key = true;
+    return *this;
+  }
+
+  writer& writer::value(const json::value& value) {
+    separate();
+    write(value);
+    return *this;
+  }
+
+  void writer::write(const json::value& value) {
+    using json::value_type;
+    switch(value.type) {
+      case value_type::object: {
+        put("{ ");
+
+        for(bool first = true; const auto& [key, element] : *value.dict) {
+          if(!first) put(", ");
+          first = false;
+
+          string(key.as_string_view());
+          put(": ");
+          write(element);
+        }
+
+        put(" }");
+      } break;
+
+      case value_type::array: {
+        put('[');
+
+        for(bool first = true; const auto& element : *value.array) {
+          if(!first) put(", ");
+          first = false;
+          write(element);
+        }
+
+        put(']');
+      } break;
+
+      case value_type::floating:
+      case value_type::integer: {
+        if(value.flags & json::value::lexeme) {
+          put(value.lexeme_view());
+        } else if(value.type == value_type::floating) {
+          number(value.as_double());
+        } else if(value.flags & json::value::unsigned_integer) {
+          number(value.as_uint64());
+        } else {
+          number(value.as_int64());
+        }
+      } break;
+
+      case value_type::string:
+        string(value.text());
+        break;
+
+      case value_type::true_literal:
+        put("true");
+        break;
+
+      case value_type::false_literal:
+        put("false");
+        break;
+
+      case value_type::null_literal:
+        put("null");
+        break;
+
+      case value_type::undefined:
+        put(value.text());
+        break;
+    }
+  }
+
+  // Clean runs between characters that need escaping are copied whole
+  void writer::string(std::string_view str) {
+    const char* begin = str.data();
+    const char* end = begin + str.size();
+
+    put('"');
+
+    while(true) {
+      const char* special = simd::find_escape(begin, end, options.escape_unicode);
+      put(std::string_view(begin, special - begin));
+      if(special == end) break;
+
+      begin = escape(special, end);
+    }
+
+    put('"');
+  }
+
+  // Writes the escape sequence for the character at `begin`, returning the
+  // end of the character
+  const char* writer::escape(const char* begin, const char* end) {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    const auto unicode = [this](std::uint32_t code) {
+      const char digits[6] = {
+        '\\', 'u', hex[code >> 12], hex[(code >> 8) & 0xf],
+        hex[(code >> 4) & 0xf], hex[code & 0xf]
+      };
+      put(std::string_view(digits, sizeof(digits)));
+    };
+
+    const unsigned char c = *begin;
+    switch(c) {
+      case '"': put("\\\""); return begin + 1;
+      case '\\': put("\\\\"); return begin + 1;
+      case '\b': put("\\b"); return begin + 1;
+      case '\f': put("\\f"); return begin + 1;
+      case '\n': put("\\n"); return begin + 1;
+      case '\r': put("\\r"); return begin + 1;
+      case '\t': put("\\t"); return begin + 1;
+    }
+
+    if(c < 0x80) {
+      unicode(c);
+      return begin + 1;
+    }
+
+    // Decode a UTF-8 sequence, rejecting overlong forms and surrogates
+    const int length = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 0;
+    std::uint32_t code = c & (0x7f >> length);
+
+    bool valid = length > 0 && length <= end - begin && c <= 0xf4;
+    for(int i = 1; valid && i < length; ++i) {
+      valid = ((unsigned char)begin[i] & 0xc0) == 0x80;
+      code = (code << 6) | (begin[i] & 0x3f);
+    }
+
+    static constexpr std::uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    valid = valid && code >= minimum[length] && code <= 0x10ffff &&
+      (code < 0xd800 || code > 0xdfff);
+
+    if(!valid) {
+      unicode(0xfffd);
+      return begin + 1;
+    }
+
+    if(code >= 0x10000) {
+      code -= 0x10000;
+      unicode(0xd800 | (code >> 10));
+      unicode(0xdc00 | (code & 0x3ff));
+    } else {
+      unicode(code);
+    }
+
+    return begin + length;
+  }
+
+  void writer::number(std::int64_t number) {
+    char digits[24];
+    put(std::string_view(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr));
+  }
+
+  void writer::number(std::uint64_t number) {
+    char digits[24];
+    put(std::string_view(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr));
+  }
+
+  // The shortest text that parses back to the same double, independent of
+  // the locale. JSON has no infinities or NaN, so those are written as null.
+  void writer::number(double number) {
+    if(!std::isfinite(number)) {
+      put("null");
+      return;
+    }
+
+    char digits[32];
+    char* end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+
+    // Keep integral floats distinguishable from integers
+    if(std::string_view(digits, end).find_first_of(".e") == std::string_view::npos) {
+      *end++ = '.';
+      *end++ = '0';
+    }
+
+    put(std::string_view(digits, end));
+  }
+
+  writer& writer::value(std::string_view str) {
+    separate();
+    string(str);
+    return *this;
+  }
+
+  writer& writer::value(const std::string& str) {
+    return value(std::string_view(str));
+  }
+
+  writer& writer::value(const char* str) {
+    return value(std::string_view(str));
+  }
+
+  writer& writer::value(bool boolean) {
+    separate();
+    put(boolean ? "true" : "false");
+    return *this;
+  }
+
+  writer& writer::value(int number) {
+    return value((std::int64_t)number);
+  }
+
+  writer& writer::value(std::int64_t number) {
+    separate();
+    this->number(number);
+    return *this;
+  }
+
+  writer& writer::value(std::uint64_t number) {
+    separate();
+    this->number(number);
+    return *this;
+  }
+
+  writer& writer::value(double number) {
+    separate();
+    this->number(number);
+    return *this;
+  }
+
+  writer& writer::null() {
+    separate();
+    put("null");
+    return *this;
+  }
+}
@@ -1,6 +1,62 @@
 #include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <new>
 #include <random>
+#include <sstream>
 #include <json.h>
+#include <simd.h>
+#include <typed.h>
+
+// Counts heap allocations and their bytes, so that tests can check that an
+// operation does not copy what it should move
+namespace {
+	std::atomic<size_t> allocations{0};
+	std::atomic<size_t> allocated_bytes{0};
+
+	void* allocate(size_t size) {
+		allocations++;
+		allocated_bytes += size;
+		if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+		throw std::bad_alloc();
+	}
+
+	void deallocate(void* ptr) noexcept {
+		std::free(ptr);
+	}
+}
+
+void* operator new(size_t size) {
+	return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	deallocate(ptr);
+}
+
+// Containers of values allocate through std::pmr::new_delete_resource, which
+// passes the alignment
+void* operator new(size_t size, std::align_val_t alignment) {
+	const size_t align = (size_t)alignment;
+	allocations++;
+	allocated_bytes += size;
+	if(void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+	deallocate(ptr);
+}
 
 TEST_CASE("RFC 8259 example 1", "[rfc8259]") {
 	auto json = json::load("./files/rfc13-1.json");
@@ -45,14 +101,695 @@ TEST_CASE("RFC 8259 example 2", "[rfc8259]") {
 	REQUIRE(json[1]["Country"] == "US");
 }
 
+TEST_CASE("Arena documents", "[document]") {
+	json::document document;
+	const json::value& json = document.load("./files/rfc13-1.json");
+	REQUIRE(json["Image"]["Width"] == 800);
+	REQUIRE(json["Image"]["Title"] == "View from 15th Floor");
+	REQUIRE(json["Image"]["IDs"][3] == 38793);
+
+	// Copies leave the arena and outlive the document's next parse
+	json::value thumbnail = json["Image"]["Thumbnail"];
+	document.parse("[1, 2, 3]");
+	REQUIRE(document.root().size() == 3);
+	REQUIRE(thumbnail["Url"] == "http://www.example.com/image/481989943");
+	REQUIRE(thumbnail["Width"] == 100);
+}
+
+TEST_CASE("Mapped files", "[document]") {
+	json::document document;
+	const json::value& json = document.load("./files/rfc13-1.json", { .in_situ = true });
+	REQUIRE(json["Image"]["Title"] == "View from 15th Floor");
+	REQUIRE(json["Image"]["Thumbnail"]["Url"] == "http://www.example.com/image/481989943");
+
+	json::value copy = json["Image"];
+	document.load("./files/rfc13-2.json", { .in_situ = true });
+	REQUIRE(document.root()[1]["City"] == "SUNNYVALE");
+	REQUIRE(copy["Title"] == "View from 15th Floor");
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json::load("./files/missing.json"), json::exception);
+	REQUIRE_THROWS_AS(document.load("./files/missing.json"), json::exception);
+	#else
+	REQUIRE(json::load("./files/missing.json").error());
+	REQUIRE(document.load("./files/missing.json").error());
+	#endif
+}
+
+TEST_CASE("Snapshots", "[document]") {
+	auto document = json::load("./files/rfc13-1.json");
+	json::value catalog = json::parse(R"({"big": 18446744073709551615, "negative": -7, "ratio": 0.25, "flags": [true, false, null]})");
+	for(int i = 0; i < 40; ++i) catalog["key" + std::to_string(i * 7 % 40)] = "value " + std::to_string(i % 3);
+	catalog["document"] = document;
+
+	const std::string bytes = json::to_snapshot(catalog);
+	json::snapshot snapshot;
+	REQUIRE(snapshot.read(bytes));
+
+	auto root = snapshot.root();
+	REQUIRE(root.to_string() == catalog.to_string());
+	REQUIRE(root.size() == catalog.size());
+	REQUIRE(root["key21"].as_string_view() == "value 0");
+	REQUIRE(root["key39"].as_string_view() == "value 2");
+	REQUIRE(!root.find("key40"));
+	REQUIRE(root["big"].is_unsigned());
+	REQUIRE(root["big"].as_uint64() == 18446744073709551615ULL);
+	REQUIRE(root["negative"].as_int64() == -7);
+	REQUIRE(root["ratio"].as_double() == 0.25);
+	REQUIRE((bool)root["flags"][0]);
+	REQUIRE(root["flags"][2].is_null());
+	REQUIRE(root.at_pointer("/document/Image/IDs/1").as_int64() == 943);
+	REQUIRE((std::string)root["document"]["Image"]["Title"] == "View from 15th Floor");
+
+	std::string keys;
+	for(const auto& [key, value] : root["document"]["Image"].members()) keys += std::string(key) + ' ';
+	REQUIRE(keys == "Width Height Title Thumbnail Animated IDs ");
+
+	long long sum = 0;
+	for(const json::snapshot_value& id : root["document"]["Image"]["IDs"].elements()) sum += id.as_int64();
+	REQUIRE(sum == 116 + 943 + 234 + 38793);
+
+	const auto path = std::filesystem::temp_directory_path() / "json-test.snapshot";
+	REQUIRE(json::save_snapshot(catalog, path));
+	json::snapshot mapped;
+	REQUIRE(mapped.load(path));
+	REQUIRE(mapped.root().materialize().to_string() == catalog.to_string());
+
+	// Damaged and stale snapshots are rejected
+	std::string damaged = bytes;
+	damaged[damaged.size() - 3] ^= 1;
+	std::string stale = bytes;
+	stale[8] = 0;
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(snapshot.read(damaged), "snapshot: checksum mismatch");
+	REQUIRE_THROWS_WITH(snapshot.read(stale), "snapshot: unsupported version");
+	REQUIRE_THROWS_WITH(snapshot.read(bytes.substr(0, bytes.size() - 8)), "snapshot: truncated or damaged");
+	REQUIRE_THROWS_WITH(snapshot.root(), "snapshot: truncated or damaged");
+	REQUIRE_THROWS_WITH(mapped.root()["document"]["Image"]["IDs"][4], "array index out of bounds");
+	#else
+	REQUIRE(!snapshot.read(damaged));
+	REQUIRE(!snapshot.read(stale));
+	REQUIRE(snapshot.root().error());
+	REQUIRE(mapped.root()["document"]["Image"]["IDs"][4].error());
+	#endif
+
+	mapped.close();
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("Reference accessors", "[access]") {
+	const auto json = json::load("./files/rfc13-1.json");
+	const json::value& image = json["Image"];
+	REQUIRE(&image["Thumbnail"] == &json.at("Image").at("Thumbnail"));
+	REQUIRE(json.find("Image") == &image);
+	REQUIRE(json.find("Missing") == nullptr);
+	REQUIRE(!json["Missing"].is_object());
+	REQUIRE(image.members().size() == 6);
+	REQUIRE(image["IDs"].elements().size() == 4);
+	REQUIRE(image.elements().empty());
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json.at("Missing"), json::exception);
+	REQUIRE_THROWS_AS(image["IDs"].at(4), json::exception);
+	#else
+	REQUIRE(json.at("Missing").error());
+	REQUIRE(image["IDs"].at(4).error());
+	#endif
+
+	json::value mutable_json = json;
+	mutable_json["Image"]["Width"] = 1024;
+	mutable_json["Image"]["IDs"][0] = "first";
+	mutable_json["Added"]["Nested"] = true;
+	REQUIRE(mutable_json["Image"]["Width"] == 1024);
+	REQUIRE(mutable_json["Image"]["IDs"][0] == "first");
+	REQUIRE(mutable_json["Added"]["Nested"] == true);
+	REQUIRE(json["Image"]["Width"] == 800);
+}
+
+TEST_CASE("JSON Pointer", "[access]") {
+	// RFC 6901, section 5
+	const auto json = json::parse(R"({
+		"foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3,
+		"g|h": 4, "i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8
+	})");
+
+	REQUIRE(&json.at_pointer("") == &json);
+	REQUIRE(json.at_pointer("/foo").size() == 2);
+	REQUIRE(json.at_pointer("/foo/0") == "bar");
+	REQUIRE(json.at_pointer("/") == 0);
+	REQUIRE(json.at_pointer("/a~1b") == 1);
+	REQUIRE(json.at_pointer("/c%d") == 2);
+	REQUIRE(json.at_pointer("/e^f") == 3);
+	REQUIRE(json.at_pointer("/g|h") == 4);
+	REQUIRE(json.at_pointer("/i\\j") == 5);
+	REQUIRE(json.at_pointer("/k\"l") == 6);
+	REQUIRE(json.at_pointer("/ ") == 7);
+	REQUIRE(json.at_pointer("/m~0n") == 8);
+
+	const json::path second("/foo/1");
+	REQUIRE(second.size() == 2);
+	REQUIRE(second.name(0) == "foo");
+	REQUIRE(json.find(second) == &json["foo"][1]);
+	REQUIRE(json.find(json::path("/foo/2")) == nullptr);
+	REQUIRE(json.find(json::path("/foo/01")) == nullptr);
+	REQUIRE(json.find(json::path("/foo/-")) == nullptr);
+	REQUIRE(json.find(json::path("/foo/0/bar")) == nullptr);
+
+	const std::string text = json.to_string();
+	const json::lazy_value lazy = json::parse_lazy(text);
+	REQUIRE((std::string)lazy.at_pointer(second) == "baz");
+	REQUIRE(lazy.at_pointer("/m~0n").as_int64() == 8);
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json.at_pointer("/foo/2"), json::exception);
+	REQUIRE_THROWS_AS(json.at_pointer("foo"), json::exception);
+	REQUIRE_THROWS_AS(json::path("/m~2n"), json::exception);
+	REQUIRE_THROWS_AS(lazy.at_pointer("/missing"), json::exception);
+	#else
+	REQUIRE(json.at_pointer("/foo/2").error());
+	REQUIRE(json::path("foo").error());
+	REQUIRE(json.find(json::path("/m~2n")) == nullptr);
+	REQUIRE(lazy.at_pointer("/missing").error());
+	#endif
+}
+
 TEST_CASE("RFC 8259 value examples", "[rfc8259]") {
 	REQUIRE(json::parse("\"Hello world!\"") == "Hello world!");
 	REQUIRE(json::parse("42") == 42);
 	REQUIRE(json::parse("true") == true);
 }
 
+TEST_CASE("Validation", "[rfc8259]") {
+	const auto fails = [](std::string_view text, std::string_view error, size_t offset) {
+		const json::validation result = json::validate(text);
+		REQUIRE(!result);
+		REQUIRE(result.error == error);
+		REQUIRE(result.offset == offset);
+	};
+
+	const std::string document = json::parse(R"({
+		"Image": { "Title": "View from 15th Floor £ \"quoted\"", "IDs": [116, -9.4e3, 0.5, true, null] },
+		"Names": ["Žluťoučký kůň", "日本語", "😀"]
+	})").to_string();
+
+	size_t before = allocations;
+	REQUIRE(json::validate(document));
+	REQUIRE(json::validate(" [] "));
+	REQUIRE(json::validate("\"\\ud83d\\ude00\""));
+	REQUIRE(json::validate("\"Žluťoučký kůň\""));
+	REQUIRE(allocations == before);
+
+	// What parse tolerates
+	fails("[1,]", "parsing: invalid array", 3);
+	fails("[,1]", "parsing: invalid array", 1);
+	fails(R"({"a": 1,, "b": 2})", "parsing: invalid object", 8);
+	fails(R"({"a": 1,})", "parsing: invalid object", 8);
+	fails("\"a\tb\"", "parsing: unescaped control character in string", 2);
+	fails("[1] [2]", "parsing: unexpected text after value", 4);
+
+	// Numbers, escapes and literals
+	fails("[01]", "parsing: invalid number", 2);
+	fails("[1.]", "parsing: decimal must be followed by digits", 3);
+	fails("[-]", "parsing: invalid number", 2);
+	fails(R"(["\x"])", "parsing: invalid escape sequence", 3);
+	fails(R"(["\u12G4"])", "parsing: invalid unicode character", 6);
+	fails("[nul]", "parsing: unrecognized literal", 4);
+	fails("[1, 2", "parsing: unterminated array", 5);
+	fails("\"abc", "parsing: unterminated string", 4);
+
+	// Overlong encodings, surrogates, truncated sequences and stray bytes
+	fails("\"a\xC0\xAF\"", "parsing: invalid UTF-8", 2);
+	fails("\"a\xED\xA0\x80\"", "parsing: invalid UTF-8", 2);
+	fails("\"long enough to skip words \xE6\x97\"", "parsing: invalid UTF-8", 27);
+	fails("[\"\xFF\", 01]", "parsing: invalid UTF-8", 2);
+	fails("[01, \"\xFF\"]", "parsing: invalid number", 2);
+
+	const std::string deep = std::string(2000, '[') + std::string(2000, ']');
+	fails(deep, "parsing: nesting too deep", 1024);
+	REQUIRE(json::validate(deep, 2000));
+	REQUIRE(json::parse("[1,]").size() == 1);
+}
+
 TEST_CASE("UTF-8 parsing", "[strings]") {
 	REQUIRE(json::parse("\"\\u0021\\u00A3\\u0418\\u07FF\\u1E55\\uFFFC\"") == "!£И߿ṕ￼");
+	REQUIRE(json::parse(R"("\ud83d\ude00 \uDBFF\uDFFF")") == "😀 \U0010FFFF");
+	REQUIRE(json::parse("\"Žluťoučký kůň 日本語 😀\"") == "Žluťoučký kůň 日本語 😀");
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(json::parse(R"("\ud83d")"), "parsing: unpaired surrogate");
+	REQUIRE_THROWS_WITH(json::parse(R"("\ud83dA")"), "parsing: unpaired surrogate");
+	REQUIRE_THROWS_WITH(json::parse(R"("\ude00")"), "parsing: unpaired surrogate");
+	REQUIRE_THROWS_WITH(json::parse("[\"caf\xC3\"]"), "parsing: invalid UTF-8");
+	REQUIRE_THROWS_WITH(json::parse("{\"\xED\xA0\x80\\n\": 1}"), "parsing: invalid UTF-8");
+	#else
+	REQUIRE(json::parse(R"("\ud83d")").error());
+	REQUIRE(json::parse("[\"caf\xC3\"]").error());
+	#endif
+}
+
+TEST_CASE("Escape sequences", "[strings]") {
+	REQUIRE(json::parse(R"("quote \" backslash \\ slash \/")") == "quote \" backslash \\ slash /");
+	REQUIRE(json::parse(R"("\b\f\n\r\t")") == "\b\f\n\r\t");
+}
+
+TEST_CASE("In-situ parsing", "[strings]") {
+	const std::string text = R"("a string without any escapes")";
+	json::document document;
+	const json::value& json = document.parse(text, { .in_situ = true });
+	REQUIRE(json == "a string without any escapes");
+	REQUIRE(json.as_string_view().data() == text.data() + 1);
+
+	// Escaped strings are decoded into the document instead
+	const std::string escaped = R"(["tab\tseparated text", "plain text in the input"])";
+	auto array = json::parse(escaped, { .in_situ = true });
+	REQUIRE(array[0] == "tab\tseparated text");
+	REQUIRE(array[1] == "plain text in the input");
+	REQUIRE(json::parse("42").as_string_view().empty());
+}
+
+TEST_CASE("Interned keys", "[strings]") {
+	json::symbol_table symbols;
+	const json::parse_options options{ .symbols = &symbols };
+
+	auto first = json::parse(R"([{"identifier": 1, "id": 2}, {"identifier": 3, "id": 4}])", options);
+	auto second = json::parse(R"({"identifier": 5})", options);
+	REQUIRE(symbols.size() == 1);
+
+	// Repeated keys share the table's copy, across documents too
+	const auto key = [](const json::value& object) {
+		return object.members().begin()->first.as_string_view().data();
+	};
+	REQUIRE(key(first[0]) == key(first[1]));
+	REQUIRE(key(first[0]) == key(second));
+
+	const json::symbol identifier = symbols.find("identifier");
+	REQUIRE(identifier.view() == "identifier");
+	REQUIRE(identifier == symbols.intern("identifier"));
+	REQUIRE(*first[1].find(identifier) == 3);
+	REQUIRE(first[1].find(symbols.intern("missing_key")) == nullptr);
+	REQUIRE(symbols.find("unknown_key") == json::symbol());
+
+	// Keys that were never interned are not found, not even as the empty key
+	const auto empty = json::parse(R"({"": 1, "a": 2})");
+	REQUIRE(empty.find(symbols.find("unknown_key")) == nullptr);
+	REQUIRE(*empty.find(std::string_view()) == 1);
+
+	// Symbols also find keys that were not interned, in indexed objects too
+	std::string large = "{";
+	for(int i = 0; i < 40; ++i) large += "\"key_number_" + std::to_string(i) + "\": " + std::to_string(i) + ",";
+	large += "}";
+	for(const json::value& object : { json::parse(large), json::parse(large, options) }) {
+		REQUIRE(*object.find(symbols.intern("key_number_33")) == 33);
+		REQUIRE(object.find(symbols.intern("key_number_40")) == nullptr);
+	}
+}
+
+TEST_CASE("Structural index", "[simd]") {
+	std::mt19937 random(8259);
+	const std::string alphabet = "{}[]:,\"\\ \t\nab1-";
+
+	for(int round = 0; round < 200; ++round) {
+		std::string text(random() % 300, ' ');
+		for(char& c : text) c = alphabet[random() % alphabet.size()];
+
+		std::vector<std::uint32_t> expected, actual;
+		const bool closed = json::simd::index(text, expected, json::simd::isa::scalar);
+		REQUIRE(json::simd::index(text, actual) == closed);
+		REQUIRE(actual == expected);
+
+		const char* end = text.data() + text.size();
+		REQUIRE(json::simd::find_quote(text.data(), end) ==
+				json::simd::find_quote(text.data(), end, json::simd::isa::scalar));
+
+		const std::string nested = "[" + text;
+		const char* nested_end = nested.data() + nested.size();
+		REQUIRE(json::simd::skip_container(nested.data(), nested_end) ==
+				json::simd::skip_container(nested.data(), nested_end, json::simd::isa::scalar));
+	}
+
+	std::vector<std::uint32_t> positions;
+	REQUIRE(json::simd::index(R"({"a\"b": [tru, 1]})", positions));
+	REQUIRE(positions == std::vector<std::uint32_t>{ 0, 1, 6, 7, 9, 10, 13, 15, 16, 17 });
+	REQUIRE(!json::simd::index(R"(["open)", positions));
+
+	const std::string nested = R"({"a]\"}": [[{}], "]"], "b": 1} [])";
+	REQUIRE(json::simd::skip_container(nested.data(), nested.data() + nested.size()) ==
+			nested.data() + nested.find(" []"));
+}
+
+TEST_CASE("UTF-8 validation", "[simd]") {
+	std::mt19937 random(3629);
+	const std::vector<std::string> pieces = {
+		"a", "json ", "é", "ß", "Ж", "ب", "数据", "€", "😀", "\U0010FFFF",
+		"\x80", "\xC0\xAF", "\xC2", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xFF"
+	};
+
+	for(int round = 0; round < 2000; ++round) {
+		// Mostly well-formed, so that errors fall at every offset
+		std::string text;
+		while(text.size() < random() % 200) {
+			text += pieces[random() % 50 ? random() % 10 : 10 + random() % 7];
+		}
+
+		const char* end = text.data() + text.size();
+		const char* expected = json::simd::find_invalid_utf8(text.data(), end, json::simd::isa::scalar);
+		REQUIRE(json::simd::find_invalid_utf8(text.data(), end) == expected);
+		REQUIRE(json::simd::find_invalid_utf8(text.data(), end, json::simd::isa::sse2) == expected);
+	}
+
+	const std::string valid = "plain ascii, Žluťoučký kůň, 日本語, 😀 and \U0010FFFF";
+	REQUIRE(json::simd::find_invalid_utf8(valid.data(), valid.data() + valid.size()) ==
+			valid.data() + valid.size());
+
+	for(const std::string invalid : { "\xC1\xBF", "\xE0\x9F\xBF", "\xED\xBF\xBF", "\xF0\x8F\xBF\xBF",
+	                                  "\xF4\x90\x80\x80", "\xF8\x88\x80\x80\x80", "\xBF", "\xE2\x82" }) {
+		const std::string text = std::string(40, 'x') + invalid + std::string(40, 'x');
+		REQUIRE(json::simd::find_invalid_utf8(text.data(), text.data() + text.size()) == text.data() + 40);
+	}
+}
+
+TEST_CASE("Indexed parsing", "[simd]") {
+	std::string text = "[\n";
+	for(int i = 0; i < 1000; ++i) {
+		text += R"(  { "id": )" + std::to_string(i) +
+			R"(, "name": "item \"quoted\"", "tags": [true, false, null] },)" + "\n";
+	}
+	text += "  \"last\"\n]";
+
+	auto json = json::parse(text);
+	REQUIRE(json.size() == 1001);
+	REQUIRE(json[999]["id"] == 999);
+	REQUIRE(json[999]["name"] == "item \"quoted\"");
+	REQUIRE(json[999]["tags"][2].is_null());
+	REQUIRE(json[1000] == "last");
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json::parse(text.substr(0, text.size() - 1)), json::exception);
+	#else
+	REQUIRE(json::parse(text.substr(0, text.size() - 1)).error());
+	#endif
+}
+
+TEST_CASE("Lazy parsing", "[lazy]") {
+	const std::string text = R"({
+		"skipped": [1, {"not" "validated"}, tru],
+		"Image": {
+			"Width": 800, "Height": 600, "Title": "View from \"15th\" Floor",
+			"Thumbnail": { "Url": "http://www.example.com/image/481989943", "Height": 125 },
+			"Animated": false, "IDs": [116, 943, 234, 38793], "Ratio": 1.5,
+			"Escaped \u0041": null
+		},
+	})";
+
+	json::lazy_value json = json::parse_lazy(text);
+	REQUIRE(json.is_object());
+	REQUIRE(json.size() == 2);
+
+	const json::lazy_value image = json["Image"];
+	REQUIRE(image.is_object());
+	REQUIRE((int)image["Width"] == 800);
+	REQUIRE(image["Height"].as_int64() == 600);
+	REQUIRE((std::string)image["Title"] == "View from \"15th\" Floor");
+	REQUIRE(image["Title"].raw_string_view() == R"(View from \"15th\" Floor)");
+	REQUIRE((std::string)image["Thumbnail"]["Url"] == "http://www.example.com/image/481989943");
+	REQUIRE(image["Animated"].is_bool());
+	REQUIRE(!(bool)image["Animated"]);
+	REQUIRE(image["Ratio"].is_float());
+	REQUIRE(image["Ratio"].as_double() == 1.5);
+	REQUIRE(image["Escaped A"].is_null());
+	REQUIRE(!image["Missing"].is_null());
+	REQUIRE(!image.find("Missing"));
+	REQUIRE(image["IDs"].size() == 4);
+	REQUIRE(image["IDs"][3].as_uint64() == 38793);
+	REQUIRE(image["Thumbnail"].raw_json() ==
+		R"({ "Url": "http://www.example.com/image/481989943", "Height": 125 })");
+
+	std::vector<std::int64_t> ids;
+	for(const json::lazy_value& id : image["IDs"].elements()) ids.push_back(id.as_int64());
+	REQUIRE(ids == std::vector<std::int64_t>{116, 943, 234, 38793});
+
+	std::vector<std::string_view> keys;
+	for(const json::lazy_member& member : image.members()) keys.push_back(member.key);
+	REQUIRE(keys.size() == 8);
+	REQUIRE(keys.front() == "Width");
+	REQUIRE(keys.back() == "Escaped \\u0041");
+
+	const json::value tree = image.materialize();
+	REQUIRE(tree.to_string() == json::parse(image.raw_json()).to_string());
+	REQUIRE(tree["Thumbnail"]["Height"] == 125);
+
+	// Repeated keys resolve as parse resolves them
+	const std::string repeated = R"({"a": 2, "b": 1, "a": 3})";
+	REQUIRE((int)json::parse_lazy(repeated)["a"] == 3);
+	REQUIRE(json::parse(repeated)["a"] == 3);
+
+	REQUIRE(json::parse_lazy(" 42 ").as_int64() == 42);
+	REQUIRE((std::string)json::parse_lazy(R"("top")") == "top");
+
+	// Subtrees are validated when they are accessed
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json["skipped"][1]["not"], json::exception);
+	REQUIRE_THROWS_AS(json["skipped"].size(), json::exception);
+	REQUIRE_THROWS_AS(image["IDs"][4], json::exception);
+	REQUIRE_THROWS_AS(json::parse_lazy("[1, 2").size(), json::exception);
+	REQUIRE_THROWS_AS(json::parse_lazy("nul"), json::exception);
+	REQUIRE_THROWS_AS(json::parse_lazy(R"({"a" 1})")["a"], json::exception);
+	#else
+	REQUIRE(json["skipped"][1]["not"].error());
+	REQUIRE(json["skipped"][2].error());
+	REQUIRE(image["IDs"][4].error());
+	REQUIRE(json::parse_lazy("[1, 2")[2].error());
+	REQUIRE(json::parse_lazy("nul").error());
+	REQUIRE(json::parse_lazy(R"({"a" 1})")["a"].error());
+	#endif
+	REQUIRE(json["skipped"][0].as_int64() == 1);
+	REQUIRE(json["skipped"][1].is_object());
+}
+
+TEST_CASE("Literals", "[types]") {
+	auto json = json::parse("[true, false, null]");
+	REQUIRE(json.size() == 3);
+	REQUIRE(json[0] == true);
+	REQUIRE(json[2].is_null());
+	REQUIRE(json::parse(R"({"a": null})")["a"].is_null());
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json::parse("[nul]"), json::exception);
+	REQUIRE_THROWS_AS(json::parse("[truex]"), json::exception);
+	#else
+	REQUIRE(json::parse("[nul]").error());
+	REQUIRE(json::parse("[truex]").error());
+	#endif
+}
+
+namespace {
+	// Records events as a compact trace, stopping at the first key "stop"
+	struct trace_handler : json::handler {
+		std::string trace;
+
+		bool on_object_begin() override { trace += '{'; return true; }
+		bool on_object_end() override { trace += '}'; return true; }
+		bool on_array_begin() override { trace += '['; return true; }
+		bool on_array_end() override { trace += ']'; return true; }
+		bool on_key(std::string_view key) override {
+			trace += "k:" + std::string(key) + ' ';
+			return key != "stop";
+		}
+		bool on_string(std::string_view str) override { trace += "s:" + std::string(str) + ' '; return true; }
+		bool on_int64(std::int64_t i) override { trace += "i:" + std::to_string(i) + ' '; return true; }
+		bool on_uint64(std::uint64_t u) override { trace += "u:" + std::to_string(u) + ' '; return true; }
+		bool on_double(double) override { trace += "d "; return true; }
+		bool on_bool(bool b) override { trace += b ? "t " : "f "; return true; }
+		bool on_null() override { trace += "n "; return true; }
+	};
+}
+
+TEST_CASE("Event parsing", "[events]") {
+	trace_handler events;
+	REQUIRE(json::parse_events(R"({"a\"b": [1, -2, 18446744073709551615, 0.5], "c": {"d": "e\n"}, "f": [true, false, null]})", events));
+	REQUIRE(events.trace == "{k:a\"b [i:1 i:-2 u:18446744073709551615 d ]k:c {k:d s:e\n }k:f [t f n ]}");
+
+	trace_handler stopped;
+	REQUIRE(!json::parse_events(R"({"a": 1, "stop": 2, "b": 3})", stopped));
+	REQUIRE(stopped.trace == "{k:a i:1 k:stop ");
+
+	trace_handler malformed;
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(json::parse_events(R"({"a": 1 "b": 2})", malformed), json::exception);
+	#else
+	REQUIRE(!json::parse_events(R"({"a": 1 "b": 2})", malformed));
+	#endif
+	REQUIRE(malformed.trace == "{k:a i:1 ");
+}
+
+TEST_CASE("Selecting paths from events", "[events]") {
+	const std::string text = R"({
+		"skipped": {"Url": "not this one", "IDs": [0, 0, 0]},
+		"Image": {
+			"Width": 800, "Title": "View from 15th Floor",
+			"Thumbnail": { "Url": "http://www.example.com/image/481989943", "Height": 125 },
+			"IDs": [116, 943, 234, 38793]
+		}
+	})";
+
+	const std::vector<json::path> paths = {
+		json::path("/Image/Thumbnail/Url"), json::path("/Image/IDs/2"),
+		json::path("/Image/Thumbnail"), json::path("/missing"), json::path("/Image/Width"),
+	};
+
+	std::map<size_t, std::string> found;
+	json::selector selector(paths, [&](size_t path, const json::value& value) {
+		found[path] = value.to_string();
+	});
+
+	REQUIRE(json::parse_events(text, selector));
+	REQUIRE(found.size() == 4);
+	REQUIRE(found[0] == "\"http://www.example.com/image/481989943\"");
+	REQUIRE(found[1] == "234");
+	REQUIRE(found[2] == R"({ "Url": "http://www.example.com/image/481989943", "Height": 125 })");
+	REQUIRE(found[4] == "800");
+
+	// The parse stops once everything has been found, and paths work on
+	// chunked input too
+	found.clear();
+	json::selector first({ json::path("/Image/Width"), json::path("/skipped/IDs") },
+		[&](size_t path, const json::value& value) { found[path] = value.to_string(); });
+	json::parser parser(first);
+
+	bool running = true;
+	for(size_t i = 0; running && i < text.size(); i += 7) {
+		running = parser.feed(std::string_view(text).substr(i, 7));
+	}
+
+	REQUIRE(!running);
+	REQUIRE(found.size() == 2);
+	REQUIRE(found[0] == "800");
+	REQUIRE(found[1] == "[0, 0, 0]");
+
+	found.clear();
+	json::selector whole({ json::path() }, [&](size_t path, const json::value& value) {
+		found[path] = value.to_string();
+	});
+	REQUIRE(!json::parse_events("[1, [2]]", whole));
+	REQUIRE(found[0] == "[1, [2]]");
+}
+
+TEST_CASE("Chunked parsing", "[events]") {
+	const std::string text = R"({"name": "caf\u00e9 \"au\" lait", "n": [-12.5e3, 0, 18446744073709551615],
+		"ok": true, "none": null, "nested": [{"a\\b": false}, []]} trailing)";
+	const std::string expected = json::parse(text).to_string();
+
+	// Every split into two chunks, and one byte at a time
+	for(size_t i = 0; i <= text.size(); ++i) {
+		json::parser parser;
+		REQUIRE(parser.feed(text.substr(0, i)));
+		REQUIRE(parser.feed(text.substr(i)));
+		REQUIRE(parser.finish());
+		REQUIRE(parser.root().to_string() == expected);
+	}
+
+	json::parser bytes;
+	for(char c : text) REQUIRE(bytes.feed(std::string_view(&c, 1)));
+	REQUIRE(bytes.done());
+	REQUIRE(bytes.root().to_string() == expected);
+
+	trace_handler direct, streamed;
+	json::parse_events(text, direct);
+	json::parser events{streamed};
+	for(size_t i = 0; i < text.size(); i += 3) REQUIRE(events.feed(text.substr(i, 3)));
+	REQUIRE(events.finish());
+	REQUIRE(streamed.trace == direct.trace);
+
+	// A number or literal at the end is only complete once the input ends
+	json::parser number;
+	REQUIRE(number.feed("12"));
+	REQUIRE(number.feed("34"));
+	REQUIRE(!number.done());
+	REQUIRE(number.finish());
+	REQUIRE(number.root() == 1234);
+
+	json::parser truncated;
+	REQUIRE(truncated.feed(R"({"a": [1, 2)"));
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_AS(truncated.finish(), json::exception);
+	#else
+	REQUIRE(!truncated.finish());
+	REQUIRE(truncated.root().error());
+	#endif
+}
+
+TEST_CASE("JSON Lines", "[lines]") {
+	// Enough records for several chunks per thread
+	std::string text;
+	for(int i = 0; i < 20000; ++i) {
+		text += R"({"id": )" + std::to_string(i) + R"(, "name": "record number )" + std::to_string(i) + "\"}";
+		text += i % 3 ? "\n" : "\r\n\n";
+	}
+
+	auto records = json::parse_lines(text, { .threads = 4 });
+	REQUIRE(records.size() == 20000);
+	REQUIRE(records[0]["id"] == 0);
+	REQUIRE(records[12345]["name"] == "record number 12345");
+	REQUIRE(records[19999]["id"] == 19999);
+
+	std::atomic<long long> sum{0};
+	json::parse_lines(text, [&](const json::value& record) {
+		sum += record["id"].as_int64();
+	}, { .threads = 4 });
+	REQUIRE(sum == 20000LL * 19999 / 2);
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(json::parse_lines("[1]\n\n[2,\n[3]", { .threads = 2 }),
+		"line 3: parsing: unterminated array");
+	#else
+	auto errors = json::parse_lines("[1]\n\n[2,\n[3]", { .threads = 2 });
+	REQUIRE(errors.size() == 3);
+	REQUIRE(errors[1].error());
+	REQUIRE(errors[2][0] == 3);
+	#endif
+}
+
+TEST_CASE("Parallel parsing", "[parallel]") {
+	// Large enough to be divided, with brackets and commas inside strings
+	std::string array = "[,", object = "{\"id\": -1, ";
+	for(int i = 0; i < 30000; ++i) {
+		std::string record = R"({"id": )" + std::to_string(i) +
+			R"(, "name": "item [)" + std::to_string(i) + R"(], {a, b}", "tags": ["\"x\"", [], {}], "ratio": 0.25})";
+		array += record + ",\n";
+		object += "\"k" + std::to_string(i) + "\": " + record + ", ";
+	}
+	array += "1]";
+	object += "\"id\": 30000}";
+	REQUIRE(array.size() > 2 * 1024 * 1024);
+
+	for(const std::string& text : { array, object }) {
+		auto serial = json::parse(text);
+		auto parallel = json::parse_parallel(text, { .threads = 4 });
+		REQUIRE(parallel.size() == serial.size());
+		REQUIRE(parallel.to_string() == serial.to_string());
+	}
+
+	auto records = json::parse_parallel(object, { .threads = 3 });
+	REQUIRE(records["id"] == 30000);
+	REQUIRE(records["k29999"]["name"] == "item [29999], {a, b}");
+
+	REQUIRE(json::parse_parallel("[1, [2, 3]]", { .threads = 4 })[1][0] == 2);
+	REQUIRE(json::parse_parallel(" 42 ", { .threads = 4 }) == 42);
+
+	// A malformed element in the middle of the document
+	std::string broken = array;
+	broken.insert(broken.find(",\n", broken.size() / 2) + 2, "tru, ");
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(json::parse_parallel(array.substr(0, array.size() - 1), { .threads = 4 }),
+		"parsing: unterminated array");
+	REQUIRE_THROWS_WITH(json::parse_parallel(broken, { .threads = 4 }),
+		"parsing: unrecognized literal");
+	#else
+	REQUIRE(json::parse_parallel(array.substr(0, array.size() - 1), { .threads = 4 }).error());
+	REQUIRE(json::parse_parallel(broken, { .threads = 4 }).error());
+	#endif
 }
 
 TEST_CASE("Vectorize homogeneous arrays", "[numbers]") {
@@ -63,6 +800,56 @@ TEST_CASE("Vectorize homogeneous arrays", "[numbers]") {
 	REQUIRE((double)sum / vector.size() == 5.5);
 }
 
+TEST_CASE("Binary numbers", "[numbers]") {
+	auto json = json::parse("[1e3, -2.5E-2, 9223372036854775807, 18446744073709551615, 1e400, 184467440737095516150]");
+	REQUIRE(json[0].is_float());
+	REQUIRE(json[0].as_double() == 1000.0);
+	REQUIRE(json[1] == -0.025);
+	REQUIRE(json[2].as_int64() == INT64_MAX);
+	REQUIRE(json[3].is_unsigned());
+	REQUIRE(json[3].as_uint64() == UINT64_MAX);
+	REQUIRE_FALSE(json[3] == -1);
+	REQUIRE(json::value(std::uint64_t(7)) == 7);
+	REQUIRE(json[4].as_double() == HUGE_VAL);
+	REQUIRE(json[5].is_float());
+	REQUIRE(json[5].as_double() == 184467440737095516150.0);
+
+	REQUIRE(json::value(42).to_string() == "42");
+	REQUIRE(json::value(2.0).to_string() == "2.0");
+	REQUIRE(json::parse(json::value(0.1).to_string()) == 0.1);
+	REQUIRE(json::value(json::value_type::integer, "-17").as_int64() == -17);
+
+	// Lexemes are only kept on request
+	const std::string text = "[1.50, 100e-2]";
+	REQUIRE(json::parse(text).to_string() == "[1.5, 1.0]");
+	json::document document;
+	const json::value& exact = document.parse(text, { .number_lexemes = true });
+	REQUIRE(exact.to_string() == "[1.50, 100e-2]");
+	REQUIRE(exact[1].lexeme_view() == "100e-2");
+	REQUIRE(exact[1] == 1.0);
+	REQUIRE(json::parse(text, { .number_lexemes = true })[0].lexeme_view() == "1.50");
+}
+
+TEST_CASE("Shortest doubles", "[numbers]") {
+	REQUIRE(json::value(0.1).to_string() == "0.1");
+	REQUIRE(json::value(1.5).to_string() == "1.5");
+	REQUIRE(json::value(1e-9).to_string() == "1e-09");
+	REQUIRE(json::value(-1e300).to_string() == "-1e+300");
+	REQUIRE(json::value(100.0).to_string() == "100.0");
+	REQUIRE(json::value(NAN).to_string() == "null");
+	REQUIRE(json::array({ INFINITY, -INFINITY }).to_string() == "[null, null]");
+
+	// Any finite double survives a round trip bit for bit
+	std::mt19937_64 random(11);
+	for(int i = 0; i < 10000; ++i) {
+		const double number = std::bit_cast<double>(random());
+		if(!std::isfinite(number)) continue;
+
+		const json::value parsed = json::parse(json::value(number).to_string());
+		REQUIRE(std::bit_cast<std::uint64_t>(parsed.as_double()) == std::bit_cast<std::uint64_t>(number));
+	}
+}
+
 TEST_CASE("Pi test", "[numbers]") {
 	auto json = json::parse(R"(["3", ".", "1", "4", "1", "5", "9", "2", "6", "5", "3", "5"])");
 	std::vector<std::string> digits = json.to_vector<std::string>();
@@ -76,8 +863,202 @@ TEST_CASE("Stringify", "[stringify]") {
 	REQUIRE(json.to_string() == "[1, 2, 3]");
 
 	json::value obj = { { "name", "bob" }, { "level", 42 } };
-	REQUIRE((obj.to_string() == "{ \"name\": \"bob\", \"level\": 42 }" ||
-			 obj.to_string() == "{ \"level\": 42, \"name\": \"bob\" }"));
+	REQUIRE(obj.to_string() == "{ \"name\": \"bob\", \"level\": 42 }");
+}
+
+TEST_CASE("Member order", "[types]") {
+	const std::string text = R"({ "z": 1, "a": 2, "m": { "y": true, "b": null }, "a": 3 })";
+	auto json = json::parse(text);
+	REQUIRE(json.to_string() == R"({ "z": 1, "a": 3, "m": { "y": true, "b": null } })");
+	REQUIRE(json.keys() == std::vector<std::string>{ "z", "a", "m" });
+
+	// Large objects are indexed, and keep their order all the same
+	std::string large = "{";
+	for(int i = 0; i < 100; ++i) {
+		large += (i ? ", \"k" : "\"k") + std::to_string(99 - i) + "\": " + std::to_string(i);
+	}
+	large += "}";
+
+	for(const bool arena : { false, true }) {
+		json::document document;
+		const json::value& object = arena ? document.parse(large) : json::parse(large);
+		REQUIRE(object.size() == 100);
+		REQUIRE(object.members().begin()->first.as_string_view() == "k99");
+		for(int i = 0; i < 100; ++i) {
+			REQUIRE(object["k" + std::to_string(i)] == 99 - i);
+		}
+		REQUIRE(object.find("k100") == nullptr);
+		REQUIRE(object.to_string() == json::value(object).to_string());
+	}
+
+	json::value growing = json::value(json::value_type::object);
+	for(int i = 0; i < 40; ++i) growing[std::to_string(i)] = i;
+	growing["7"] = "seven";
+	REQUIRE(growing.size() == 40);
+	REQUIRE(growing["7"] == "seven");
+	REQUIRE(growing.keys()[7] == "7");
+}
+
+TEST_CASE("Writer", "[stringify]") {
+	std::string output;
+	{
+		json::writer writer(output);
+		writer.begin_object()
+			.key("ids").begin_array().value(1).value(-2).value(std::uint64_t(3)).end_array()
+			.key("ratio").value(0.5)
+			.key("name").value("bob")
+			.key("empty").begin_array().end_array()
+			.key("tree").value(json::array({ true, json::value(json::value_type::null_literal) }))
+			.end_object();
+	}
+	REQUIRE(output == R"({ "ids": [1, -2, 3], "ratio": 0.5, "name": "bob", "empty": [], "tree": [true, null] })");
+	REQUIRE(json::parse(output)["ids"][1] == -2);
+
+	// Output larger than the writer's buffer reaches the sink in blocks
+	const json::value big = std::string(100000, 'x');
+	std::string blocks;
+	size_t calls = 0;
+	{
+		json::writer writer([&](std::string_view block) {
+			blocks += block;
+			calls++;
+		});
+		for(int i = 0; i < 1000; ++i) writer.value(big);
+	}
+	REQUIRE(calls > 1);
+	REQUIRE(blocks.size() == 1000 * big.to_string().size());
+
+	#ifndef NO_EXCEPTIONS
+	// Sink errors reach flush() but never escape the destructor, even while
+	// an earlier one unwinds the stack
+	const auto failing = [](std::string_view) { throw json::exception("sink failed"); };
+	{
+		json::writer writer(failing);
+		writer.value(1);
+		REQUIRE_THROWS_WITH(writer.flush(), "sink failed");
+		writer.value(2);
+	}
+	REQUIRE_THROWS_WITH([&] {
+		json::writer writer(failing);
+		for(int i = 0; i < 1000; ++i) writer.value(big);
+	}(), "sink failed");
+
+	// Containers must be ended in the order they were begun
+	std::string unbalanced;
+	json::writer writer(unbalanced);
+	REQUIRE_THROWS_WITH(writer.end_array(), "writing: unbalanced end_object/end_array");
+	writer.begin_object();
+	REQUIRE_THROWS_WITH(writer.end_array(), "writing: unbalanced end_object/end_array");
+	writer.end_object();
+	REQUIRE_THROWS_WITH(writer.end_object(), "writing: unbalanced end_object/end_array");
+	REQUIRE(unbalanced == "{  }");
+	#endif
+
+	std::ostringstream stream;
+	stream << json::array({ 1, "two" });
+	REQUIRE(stream.str() == R"([1, "two"])");
+}
+
+TEST_CASE("String escaping", "[stringify]") {
+	std::string text = "quote \" backslash \\ slash / tab \t newline \n";
+	for(char c = 1; c < 0x20; ++c) text += c;
+
+	const json::value value = text;
+	const std::string written = value.to_string();
+	REQUIRE(written.find('\n') == std::string::npos);
+	REQUIRE(written.substr(0, 31) == R"("quote \" backslash \\ slash / )");
+	REQUIRE(json::parse(written) == text);
+
+	json::value object = { { "k\"ey", "caf\xc3\xa9" } };
+	REQUIRE(object.to_string() == "{ \"k\\\"ey\": \"caf\xc3\xa9\" }");
+
+	const json::write_options ascii{ .escape_unicode = true };
+	REQUIRE(object.to_string(ascii) == R"({ "k\"ey": "caf\u00e9" })");
+	REQUIRE(json::value("\xf0\x9f\x98\x80").to_string(ascii) == R"("\ud83d\ude00")");
+	REQUIRE(json::value("\xe2\x82\xac \xff \xc0\xaf").to_string(ascii) == R"("\u20ac \ufffd \ufffd\ufffd")");
+
+	// Every instruction set finds the same first special character
+	std::mt19937 random(7);
+	const char alphabet[] = "abc \"\\\x01\x1f\x7f\x80\xff";
+	for(int i = 0; i < 1000; ++i) {
+		std::string sample(random() % 100, 'x');
+		for(char& c : sample) {
+			if(random() % 8 == 0) c = alphabet[random() % (sizeof(alphabet) - 1)];
+		}
+
+		const char* begin = sample.data();
+		const char* end = begin + sample.size();
+		for(bool unicode : { false, true }) {
+			const char* expected = json::simd::find_escape(begin, end, unicode, json::simd::isa::scalar);
+			for(auto target : { json::simd::isa::sse2, json::simd::isa::avx2 }) {
+				if(target > json::simd::detect()) continue;
+				REQUIRE(json::simd::find_escape(begin, end, unicode, target) == expected);
+			}
+		}
+	}
+}
+
+TEST_CASE("Editing in place", "[types]") {
+	json::value rows;
+	for(int i = 0; i < 10000; ++i) {
+		json::value& row = rows.emplace_back(json::value(json::value_type::object));
+		row.reserve(2);
+		row.insert_or_assign("id", i);
+		row.insert_or_assign("name", "a name long enough to be allocated " + std::to_string(i));
+	}
+	REQUIRE(rows.size() == 10000);
+
+	// Subtrees are moved into place, never copied
+	size_t before = allocations;
+	json::value response{ { "status", "ok" }, { "rows", std::move(rows) } };
+	json::value list;
+	json::value& moved = list.emplace_back(std::move(response));
+	moved.insert_or_assign("count", 10000);
+	REQUIRE(allocations - before < 10);
+
+	REQUIRE(moved["rows"][9999]["name"] == "a name long enough to be allocated 9999");
+	moved["rows"][0].insert_or_assign("id", -1);
+	REQUIRE(moved["rows"][0]["id"] == -1);
+
+	REQUIRE(moved.erase("status") == 1);
+	REQUIRE(moved.erase("status") == 0);
+	REQUIRE(moved["rows"].erase(0) == 1);
+	REQUIRE(moved["rows"].erase(10000) == 0);
+	REQUIRE(moved["rows"][0]["id"] == 1);
+	REQUIRE(moved.to_string().starts_with(R"({ "rows": [{ "id": 1, "name")"));
+
+	// Erasing from an indexed object keeps the order and the index
+	json::value wide;
+	for(int i = 0; i < 40; ++i) wide.insert_or_assign("k" + std::to_string(i), i);
+	for(int i = 0; i < 40; i += 2) REQUIRE(wide.erase("k" + std::to_string(i)) == 1);
+	REQUIRE(wide.size() == 20);
+	REQUIRE(wide.keys().front() == "k1");
+	for(int i = 1; i < 40; i += 2) REQUIRE(wide["k" + std::to_string(i)] == i);
+	REQUIRE(!wide.find("k2"));
+
+	json::value number = 5;
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(number.emplace_back(1), "value is not an array");
+	REQUIRE_THROWS_WITH(number.insert_or_assign("a", 1), "value is not an object");
+	#else
+	REQUIRE(number.emplace_back(1).error());
+	REQUIRE(number.insert_or_assign("a", 1).error());
+	#endif
+}
+
+TEST_CASE("Copy and move", "[types]") {
+	json::value obj = { { "name", "bob" }, { "scores", json::array({ 1, 2, 3 }) } };
+
+	json::value copy = obj;
+	copy = json::array({ "replaced" });
+	REQUIRE(obj["name"] == "bob");
+	REQUIRE(obj["scores"][2] == 3);
+	REQUIRE(copy[0] == "replaced");
+
+	json::value moved = std::move(obj);
+	REQUIRE(moved["name"] == "bob");
+	REQUIRE(moved["scores"].size() == 3);
+	REQUIRE(sizeof(json::value) == 16);
 }
 
 TEST_CASE("Round-trip conversion", "[stringify]") {
@@ -131,6 +1112,165 @@ TEST_CASE("Round-trip conversion", "[stringify]") {
 	REQUIRE(round_trip["Image"]["IDs"][3] == 38793);
 }
 
+namespace {
+	struct thumbnail {
+		std::string url;
+		int height = 0;
+		int width = 0;
+	};
+
+	struct image {
+		int width = 0;
+		int height = 0;
+		std::string title;
+		thumbnail preview;
+		bool animated = true;
+		std::vector<std::uint32_t> ids;
+		std::optional<double> ratio;
+		std::map<std::string, json::value> extra;
+	};
+
+	JSON_FIELDS(thumbnail, url, height, width)
+	JSON_FIELDS(image, width, height, title, preview, animated, ids, ratio, extra)
+}
+
+TEST_CASE("Binary encodings", "[binary]") {
+	auto bytes = [](std::initializer_list<int> list) {
+		std::string result;
+		for(int byte : list) result.push_back((char)byte);
+		return result;
+	};
+
+	auto document = json::parse(R"({"id": 1000, "name": "Grace", "scores": [-1, -1000, 0.5, 0.1, 1e300],
+		"big": 18446744073709551615, "min": -9223372036854775808, "ok": true, "none": null, "nested": {"a": [[], {}]}})");
+
+	for(const std::string& encoded : { json::to_cbor(document), json::to_msgpack(document) }) {
+		auto decoded = encoded == json::to_cbor(document) ? json::from_cbor(encoded) : json::from_msgpack(encoded);
+		REQUIRE(decoded.to_string() == document.to_string());
+		REQUIRE(decoded["big"].is_unsigned());
+		REQUIRE(decoded["scores"][3].as_double() == 0.1);
+		REQUIRE(encoded.size() < document.to_string().size());
+	}
+
+	// Examples from RFC 8949, appendix A
+	REQUIRE(json::to_cbor(json::parse("[1, [2, 3], 24, -1000]")) == bytes({ 0x84, 0x01, 0x82, 0x02, 0x03, 0x18, 0x18, 0x39, 0x03, 0xe7 }));
+	REQUIRE(json::to_cbor(json::parse(R"({"a": 1.5})")) == bytes({ 0xa1, 0x61, 0x61, 0xfa, 0x3f, 0xc0, 0x00, 0x00 }));
+	REQUIRE(json::from_cbor(bytes({ 0xf9, 0x3e, 0x00 })) == 1.5);
+	REQUIRE(json::from_cbor(bytes({ 0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0 })) == 1363896240);
+	REQUIRE(json::from_cbor(bytes({ 0x9f, 0x01, 0x7f, 0x62, 0x61, 0x62, 0x61, 0x63, 0xff, 0xff })).to_string() == R"([1, "abc"])");
+
+	// Example from the MessagePack website
+	REQUIRE(json::to_msgpack(json::parse(R"({"compact": true, "schema": 0})")) ==
+		bytes({ 0x82, 0xa7, 'c', 'o', 'm', 'p', 'a', 'c', 't', 0xc3, 0xa6, 's', 'c', 'h', 'e', 'm', 'a', 0x00 }));
+	REQUIRE(json::to_msgpack(json::parse("[-33, 200, -32]")) == bytes({ 0x93, 0xd0, 0xdf, 0xcc, 0xc8, 0xe0 }));
+	REQUIRE(json::from_msgpack(bytes({ 0x92, 0xd1, 0xfc, 0x18, 0xc4, 0x01, 'x' })).to_string() == R"([-1000, "x"])");
+
+	trace_handler events;
+	REQUIRE(json::from_msgpack(json::to_msgpack(json::parse(R"({"a": [1, -2, 0.5, "s"], "b": [true, null]})")), events));
+	REQUIRE(events.trace == "{k:a [i:1 i:-2 d s:s ]k:b [t n ]}");
+
+	// A declared length larger than the input is not reserved
+	#ifndef NO_EXCEPTIONS
+	REQUIRE_THROWS_WITH(json::from_cbor(bytes({ 0x9b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 })),
+		"cbor: unexpected end of input");
+	REQUIRE_THROWS_WITH(json::from_cbor(bytes({ 0xa1, 0x01, 0x02 })), "cbor: object keys must be strings");
+	REQUIRE_THROWS_WITH(json::from_msgpack(bytes({ 0xc1 })), "msgpack: invalid type");
+	REQUIRE_THROWS_WITH(json::from_msgpack(bytes({ 0xd4, 0x01, 0x02 })), "msgpack: unsupported extension type");
+
+	// Nor are nested ones: what they reserve together is bounded by the input
+	auto nested = [&](int type) {
+		std::string result;
+		for(int i = 0; i < 1000; ++i) result += bytes({ type, 0xff, 0xff, 0xff, 0xff });
+		return result;
+	};
+	size_t before = allocated_bytes;
+	REQUIRE_THROWS_WITH(json::from_msgpack(nested(0xdd)), "msgpack: unexpected end of input");
+	REQUIRE(allocated_bytes - before < 64 * 5000);
+	before = allocated_bytes;
+	REQUIRE_THROWS_WITH(json::from_cbor(nested(0x9a)), "cbor: unexpected end of input");
+	REQUIRE(allocated_bytes - before < 64 * 5000);
+
+	// Nesting is limited instead of overflowing the stack
+	REQUIRE(json::from_cbor(std::string(1024, '\x81') + '\x01').is_array());
+	REQUIRE_THROWS_WITH(json::from_cbor(std::string(1025, '\x81') + '\x01'), "cbor: nesting too deep");
+	REQUIRE_THROWS_WITH(json::from_cbor(std::string(2000000, '\x81')), "cbor: nesting too deep");
+	REQUIRE_THROWS_WITH(json::from_msgpack(std::string(2000000, '\x91')), "msgpack: nesting too deep");
+	REQUIRE(json::from_cbor(std::string(2000000, '\xc0') + '\x01') == 1);
+	#else
+	REQUIRE(json::from_cbor(bytes({ 0x9b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 })).error());
+	REQUIRE(json::from_cbor(bytes({ 0xa1, 0x01, 0x02 })).error());
+	REQUIRE(json::from_msgpack(bytes({ 0xc1 })).error());
+	#endif
+}
+
+TEST_CASE("Typed conversion", "[typed]") {
+	const std::string text = R"({
+		"width": 800, "height": 600, "title": "View from \"15th\" Floor",
+		"unknown": { "skipped": [1, {"deep": null}] },
+		"preview": { "url": "http://www.example.com/image/481989943", "height": 125, "width": 100 },
+		"animated": false, "ids": [116, 943, 234, 38793], "ratio": null,
+		"extra": { "b": [1, 2], "a": "text" }
+	})";
+
+	image result;
+	REQUIRE(json::parse_into(text, result));
+	REQUIRE(result.width == 800);
+	REQUIRE(result.height == 600);
+	REQUIRE(result.title == "View from \"15th\" Floor");
+	REQUIRE(result.preview.url == "http://www.example.com/image/481989943");
+	REQUIRE(result.preview.width == 100);
+	REQUIRE(!result.animated);
+	REQUIRE(result.ids == std::vector<std::uint32_t>{116, 943, 234, 38793});
+	REQUIRE(!result.ratio);
+	REQUIRE(result.extra.size() == 2);
+	REQUIRE(result.extra["b"][1] == 2);
+
+	// Members are written in declaration order, maps in key order
+	result.ratio = 1.5;
+	const std::string written = json::serialize(result);
+	REQUIRE(written == R"({ "width": 800, "height": 600, "title": "View from \"15th\" Floor", )"
+		R"("preview": { "url": "http://www.example.com/image/481989943", "height": 125, "width": 100 }, )"
+		R"("animated": false, "ids": [116, 943, 234, 38793], "ratio": 1.5, )"
+		R"("extra": { "a": "text", "b": [1, 2] } })");
+
+	image again;
+	REQUIRE(json::parse_into(written, again));
+	REQUIRE(json::serialize(again) == written);
+	REQUIRE(json::serialize(again) == json::parse(written).to_string());
+
+	// Absent members keep their value
+	thumbnail partial{"kept", 1, 2};
+	REQUIRE(json::parse_into(R"({"height": 3,})", partial));
+	REQUIRE(partial.url == "kept");
+	REQUIRE(partial.height == 3);
+	REQUIRE(partial.width == 2);
+
+	std::vector<std::optional<std::int8_t>> small;
+	REQUIRE(json::parse_into("[1, null, -128]", small));
+	REQUIRE(small.size() == 3);
+	REQUIRE(!small[1]);
+	REQUIRE(*small[2] == -128);
+	REQUIRE(json::serialize(small) == "[1, null, -128]");
+
+	const char* invalid[] = {
+		"[1, 300]", "[1, -1]", "[1.5]", "[\"1\"]", "{}", "[1 2]", "[1,", "[nul]",
+	};
+	for(const char* text : invalid) {
+		std::vector<std::uint8_t> bytes;
+		#ifndef NO_EXCEPTIONS
+		REQUIRE_THROWS_AS(json::parse_into(text, bytes), json::exception);
+		#else
+		REQUIRE(!json::parse_into(text, bytes));
+		#endif
+	}
+
+	#ifndef NO_EXCEPTIONS
+	REQUIRE(json::parse_into<std::vector<int>>("[1, 2, 3]") == std::vector<int>{1, 2, 3});
+	REQUIRE_THROWS_WITH(json::parse_into<thumbnail>(R"({"url": 5})"),
+		"converting: expected a string");
+	#endif
+}
+
 TEST_CASE("Error handling", "[errors]") {
 	#ifndef NO_EXCEPTIONS
 	try {